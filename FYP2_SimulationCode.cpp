@@ -1,371 +1,4512 @@
-#include "ns3/applications-module.h"
-#include "ns3/core-module.h"
-#include "ns3/internet-module.h"
-#include "ns3/lte-module.h"
-#include "ns3/mobility-module.h"
-#include "ns3/network-module.h"
-#include "ns3/point-to-point-module.h"
-#include "ns3/flow-monitor-module.h"
-#include "ns3/cosine-antenna-model.h"
-#include "ns3/lte-enb-phy.h"
-
-using namespace ns3;
-
-NS_LOG_COMPONENT_DEFINE("LenaHandoverSimulation");
-
-// Global counter for successful handovers
-static uint32_t g_handoverCount = 0;
-
-// Callback to count each completed handover event
-void HandoverEndOkCounter(std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
-    g_handoverCount++;
-}
-
-// Trace callbacks for connection and handover events (for logging)
-void NotifyConnectionEstablishedUe(std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
-    std::cout << Simulator::Now().As(Time::S) << " " << context 
-              << " UE IMSI " << imsi << ": connected to CellId " 
-              << cellId << " with RNTI " << rnti << std::endl;
-}
-void NotifyHandoverStartUe(std::string context, uint64_t imsi, uint16_t cellId, 
-                            uint16_t rnti, uint16_t targetCellId) {
-    std::cout << Simulator::Now().As(Time::S) << " " << context 
-              << " UE IMSI " << imsi << ": starting handover from CellId " 
-              << cellId << " to CellId " << targetCellId << std::endl;
-}
-void NotifyHandoverEndOkUe(std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
-    std::cout << Simulator::Now().As(Time::S) << " " << context 
-              << " UE IMSI " << imsi << ": completed handover to CellId " 
-              << cellId << std::endl;
-}
-void NotifyConnectionEstablishedEnb(std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
-    std::cout << Simulator::Now().As(Time::S) << " " << context 
-              << " eNB CellId " << cellId << ": UE IMSI " << imsi 
-              << " connected with RNTI " << rnti << std::endl;
-}
-void NotifyHandoverStartEnb(std::string context, uint64_t imsi, uint16_t cellId, 
-                             uint16_t rnti, uint16_t targetCellId) {
-    std::cout << Simulator::Now().As(Time::S) << " " << context 
-              << " eNB CellId " << cellId << ": initiating handover of UE IMSI " 
-              << imsi << " to CellId " << targetCellId << std::endl;
-}
-void NotifyHandoverEndOkEnb(std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
-    std::cout << Simulator::Now().As(Time::S) << " " << context 
-              << " eNB CellId " << cellId << ": successful handover of UE IMSI " 
-              << imsi << std::endl;
-}
-void NotifyHandoverFailure(std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
-    std::cout << Simulator::Now().As(Time::S) << " " << context 
-              << " eNB CellId " << cellId << " IMSI " << imsi 
-              << " handover failure (RNTI " << rnti << ")" << std::endl;
-}
-
-
-int main(int argc, char *argv[]) {
-    uint16_t numberOfUes = 41;
-    uint16_t numberOfEnbs = 21;  // 7 sites * 3 sectors each = 21 eNBs
-    Time simTime = Seconds(50.0);
-    bool disableDl = false;
-    bool disableUl = false;
-    bool useA2A4   = false;  // default: use A3-RSRP; set true for A2-A4-RSRQ
-    bool enableFading = false;
-    double hysteresis = 2.0;            // A3-RSRP hysteresis in dB (e.g. 2 dB):contentReference[oaicite:4]{index=4}
-    uint16_t timeToTrigger = 480;       // A3-RSRP TTT in ms (e.g. 480 ms):contentReference[oaicite:5]{index=5}
-    uint8_t servingCellThreshold = 30;  // A2-A4-RSRQ serving cell threshold in dB (e.g. 30 dB):contentReference[oaicite:6]{index=6}
-    uint8_t neighbourCellOffset = 2;    // A2-A4-RSRQ neighbor cell offset in dB (e.g. 2 dB)
-    double txPower = 46.0;              // eNB transmit power in dBm (46 dBm ~ 40 W):contentReference[oaicite:7]{index=7}
-    double minSpeed = 20.0;   // km/h (minimum UE speed, paper considered 20 km/h as low end):contentReference[oaicite:8]{index=8}
-    double maxSpeed = 120.0;  // km/h (maximum UE speed)
-    std::string fadingTrace = "src/lte/model/fading-traces/fading_trace_EVA_60kmph.fad";
-
-    // Parse command-line arguments
-    CommandLine cmd;
-    cmd.AddValue("numberOfUes", "Number of UEs", numberOfUes);
-    cmd.AddValue("numberOfEnbs", "Number of eNodeBs (total sectors)", numberOfEnbs);
-    cmd.AddValue("simTime", "Simulation duration (seconds)", simTime);
-    cmd.AddValue("disableDl", "Disable downlink data flows", disableDl);
-    cmd.AddValue("disableUl", "Disable uplink data flows", disableUl);
-    cmd.AddValue("useA2A4", "Use A2-A4-RSRQ handover (default: A3-RSRP)", useA2A4);
-    cmd.AddValue("enableFading", "Enable fading model (EVA/ETU trace)", enableFading);
-    cmd.AddValue("hysteresis", "A3-RSRP hysteresis (dB)", hysteresis);
-    cmd.AddValue("timeToTrigger", "A3-RSRP Time-to-Trigger (ms)", timeToTrigger);
-    cmd.AddValue("servingCellThreshold", "A2-A4-RSRQ serving cell threshold (dB)", servingCellThreshold);
-    cmd.AddValue("neighbourCellOffset", "A2-A4-RSRQ neighbor cell offset (dB)", neighbourCellOffset);
-    cmd.AddValue("txPower", "eNB transmit power (dBm)", txPower);
-    cmd.AddValue("minSpeed", "Minimum UE speed (km/h)", minSpeed);
-    cmd.AddValue("maxSpeed", "Maximum UE speed (km/h)", maxSpeed);
-    cmd.AddValue("fadingTrace", "Fading trace file path", fadingTrace);
-    cmd.Parse(argc, argv);
-
-    if (useA2A4)
-    {
-    std::cout << "*** DEBUG: A2-A4 parameters: "
-                << "servingCellThreshold=" << (int)servingCellThreshold
-                << " dB, neighbourCellOffset="   << (int)neighbourCellOffset
-                << " dB\n";
-    }
-
-    // Configure default application behavior
-    Config::SetDefault("ns3::UdpClient::Interval", TimeValue(MilliSeconds(10)));
-    Config::SetDefault("ns3::UdpClient::MaxPackets", UintegerValue(1000000));
-    Config::SetDefault ("ns3::LteHelper::UseIdealRrc", BooleanValue (true));
-    Config::SetDefault("ns3::TcpSocket::SegmentSize", UintegerValue(1024));
-
-    // Create LTE and EPC helpers
-    Ptr<LteHelper> lteHelper = CreateObject<LteHelper>();
-    Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper>();
-    lteHelper->SetEpcHelper(epcHelper);
-    lteHelper->SetSchedulerType("ns3::RrFfMacScheduler");
-    
-    //lteHelper->SetSchedulerType("ns3::PfFfMacScheduler");
-    //std::cout << "Using Proportional Fair Scheduler" << std::endl;
-
-    //lteHelper->EnableTraces();
-    // Disable LTE RLC/PDCP statistics to avoid handover crashes
-    //lteHelper->SetAttribute("EnableRlcStats", BooleanValue(false));  
-    //lteHelper->SetAttribute("EnablePdcpStats", BooleanValue(false)); 
-    // (We do not call EnableTraces(), to avoid creating LteStatsCalculator modules that caused errors)
-
-    // Configure the selected handover algorithm and its parameters
-    if (useA2A4) {
-    lteHelper->SetHandoverAlgorithmType("ns3::A2A4RsrqHandoverAlgorithm");
-    lteHelper->SetHandoverAlgorithmAttribute("ServingCellThreshold", UintegerValue(servingCellThreshold));
-    lteHelper->SetHandoverAlgorithmAttribute("NeighbourCellOffset", UintegerValue(neighbourCellOffset));
-    }
-    else {
-    lteHelper->SetHandoverAlgorithmType("ns3::A3RsrpHandoverAlgorithm");
-    lteHelper->SetHandoverAlgorithmAttribute("Hysteresis", DoubleValue(hysteresis));
-    lteHelper->SetHandoverAlgorithmAttribute("TimeToTrigger", TimeValue(MilliSeconds(timeToTrigger)));
-    }
-
-    // Set fading model (if enabled) using a trace file (EVA or ETU as appropriate):contentReference[oaicite:11]{index=11}
-    if (enableFading) {
-        lteHelper->SetAttribute("FadingModel", StringValue("ns3::TraceFadingLossModel"));
-        lteHelper->SetFadingModelAttribute("TraceFilename", StringValue(fadingTrace));
-        lteHelper->SetFadingModelAttribute("WindowSize", TimeValue(Seconds(0.5)));
-        lteHelper->SetFadingModelAttribute("SamplesNum", UintegerValue(100000));
-    }
-
-    // Set LTE eNB parameters (frequency, bandwidth, tx power, etc.):contentReference[oaicite:12]{index=12}
-    lteHelper->SetEnbDeviceAttribute("DlEarfcn", UintegerValue(100));
-    lteHelper->SetEnbDeviceAttribute("UlEarfcn", UintegerValue(18100));
-    lteHelper->SetEnbDeviceAttribute("DlBandwidth", UintegerValue(100));  // 5 MHz (25 RBs)
-    lteHelper->SetEnbDeviceAttribute("UlBandwidth", UintegerValue(100));
-    Config::SetDefault("ns3::LteEnbPhy::TxPower", DoubleValue(txPower));
-
-    // Create PGW (Packet Gateway) and a remote host for internet traffic
-    Ptr<Node> pgw = epcHelper->GetPgwNode();
-    NodeContainer remoteHostContainer;
-    remoteHostContainer.Create(1);
-    Ptr<Node> remoteHost = remoteHostContainer.Get(0);
-    InternetStackHelper internet;
-    internet.Install(remoteHostContainer);
-
-    // Connect remoteHost to PGW with a high-capacity P2P link
-    PointToPointHelper p2ph;
-    p2ph.SetDeviceAttribute("DataRate", DataRateValue(DataRate("100Gb/s")));
-    p2ph.SetDeviceAttribute("Mtu", UintegerValue(1500));
-    p2ph.SetChannelAttribute("Delay", TimeValue(MilliSeconds(0.010)));
-    NetDeviceContainer internetDevices = p2ph.Install(pgw, remoteHost);
-    Ipv4AddressHelper ipv4h;
-    ipv4h.SetBase("1.0.0.0", "255.0.0.0");
-    Ipv4InterfaceContainer internetIpIfaces = ipv4h.Assign(internetDevices);
-    Ipv4Address remoteHostAddr = internetIpIfaces.GetAddress(1);
-
-    // Add a route from the remoteHost to the LTE network (UE subnet 7.0.0.0)
-    Ipv4StaticRoutingHelper ipv4RoutingHelper;
-    Ptr<Ipv4StaticRouting> remoteHostStaticRouting = 
-        ipv4RoutingHelper.GetStaticRouting(remoteHost->GetObject<Ipv4>());
-    remoteHostStaticRouting->AddNetworkRouteTo(Ipv4Address("7.0.0.0"), Ipv4Mask("255.0.0.0"), 1);
-
-    // Create eNB and UE nodes
-    NodeContainer enbNodes;
-    NodeContainer ueNodes;
-    enbNodes.Create(numberOfEnbs);
-    ueNodes.Create(numberOfUes);
-
-    // Position 21 eNBs in a 7-site grid (2-3-2 layout), with 3 co-located sector cells per site:contentReference[oaicite:13]{index=13}
-    Ptr<ListPositionAllocator> enbPositionAlloc = CreateObject<ListPositionAllocator>();
-    // Row 1: 2 sites at y=0 (x=0 and x=500)
-    enbPositionAlloc->Add(Vector(0.0,   0.0, 0.0));
-    enbPositionAlloc->Add(Vector(0.0,   0.0, 0.0));
-    enbPositionAlloc->Add(Vector(0.0,   0.0, 0.0));      // site 1 (3 sectors)
-    enbPositionAlloc->Add(Vector(500.0, 0.0, 0.0));
-    enbPositionAlloc->Add(Vector(500.0, 0.0, 0.0));
-    enbPositionAlloc->Add(Vector(500.0, 0.0, 0.0));      // site 2
-    // Row 2: 3 sites at y=500 (x=0, 500, 1000)
-    enbPositionAlloc->Add(Vector(0.0,   500.0, 0.0));
-    enbPositionAlloc->Add(Vector(0.0,   500.0, 0.0));
-    enbPositionAlloc->Add(Vector(0.0,   500.0, 0.0));    // site 3
-    enbPositionAlloc->Add(Vector(500.0, 500.0, 0.0));
-    enbPositionAlloc->Add(Vector(500.0, 500.0, 0.0));
-    enbPositionAlloc->Add(Vector(500.0, 500.0, 0.0));    // site 4 (center)
-    enbPositionAlloc->Add(Vector(1000.0, 500.0, 0.0));
-    enbPositionAlloc->Add(Vector(1000.0, 500.0, 0.0));
-    enbPositionAlloc->Add(Vector(1000.0, 500.0, 0.0));   // site 5
-    // Row 3: 2 sites at y=1000 (x=500, 1000)
-    enbPositionAlloc->Add(Vector(500.0, 1000.0, 0.0));
-    enbPositionAlloc->Add(Vector(500.0, 1000.0, 0.0));
-    enbPositionAlloc->Add(Vector(500.0, 1000.0, 0.0));   // site 6
-    enbPositionAlloc->Add(Vector(1000.0,1000.0, 0.0));
-    enbPositionAlloc->Add(Vector(1000.0,1000.0, 0.0));
-    enbPositionAlloc->Add(Vector(1000.0,1000.0, 0.0));   // site 7
-    MobilityHelper enbMobility;
-    enbMobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-    enbMobility.SetPositionAllocator(enbPositionAlloc);
-    enbMobility.Install(enbNodes);
-
-    // Install mobility model for UEs: random initial position and constant velocity
-    MobilityHelper ueMobility;
-    ueMobility.SetMobilityModel("ns3::ConstantVelocityMobilityModel");
-    ueMobility.Install(ueNodes);
-    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
-    for (uint32_t u = 0; u < ueNodes.GetN(); ++u) {
-        Ptr<ConstantVelocityMobilityModel> mob = ueNodes.Get(u)->GetObject<ConstantVelocityMobilityModel>();
-        // Random starting position within the area (0 to 1000 m in x,y)
-        mob->SetPosition(Vector(rand->GetValue(0.0, 1000.0), rand->GetValue(0.0, 1000.0), 0.0));
-        // Assign random speed (km/h converted to m/s) and direction
-        double speedKmph = rand->GetValue(minSpeed, maxSpeed);
-        double speedMps  = speedKmph * 1000.0 / 3600.0;
-        double theta = rand->GetValue(0.0, 2 * M_PI);
-        mob->SetVelocity(Vector(speedMps * std::cos(theta), speedMps * std::sin(theta), 0.0));
-    }
-    
-    // Set antenna model type BEFORE installing eNBs
-    lteHelper->SetEnbAntennaModelType("ns3::CosineAntennaModel");
-    lteHelper->SetEnbAntennaModelAttribute("HorizontalBeamwidth", DoubleValue(65.0));
-
-    // Install eNBs with sector-specific orientations
-    NetDeviceContainer enbDevs;
-    for (uint32_t i = 0; i < enbNodes.GetN(); i++) {
-	 lteHelper->SetEnbAntennaModelAttribute("Orientation", DoubleValue((i % 3) * 120.0));
-	 Ptr<NetDevice> enbDev = lteHelper->InstallEnbDevice(enbNodes.Get(i)).Get(0);
-	 enbDevs.Add(enbDev);
-    }
-	
-    lteHelper->SetEnbAntennaModelAttribute("Orientation", DoubleValue(0.0)); // Reset
-	
-    NetDeviceContainer ueDevs  = lteHelper->InstallUeDevice(ueNodes);
-    internet.Install(ueNodes);
-    Ipv4InterfaceContainer ueIpIfaces = epcHelper->AssignUeIpv4Address(NetDeviceContainer(ueDevs));
-
-    // Attach each UE to the best available cell (initial cell selection)
-    for (uint32_t i = 0; i < ueDevs.GetN(); ++i) {
-        lteHelper->Attach(ueDevs.Get(i));  // UE will automatically connect to strongest eNB
-    }
-
-    // Install traffic applications: full-buffer TCP downlink and uplink for each UE:contentReference[oaicite:14]{index=14}
-    uint16_t dlPort = 10000;
-    uint16_t ulPort = 20000;
-    Ptr<UniformRandomVariable> startVar = CreateObject<UniformRandomVariable>();
-    startVar->SetAttribute("Min", DoubleValue(0));
-    startVar->SetAttribute("Max", DoubleValue(0.010));
-    for (uint32_t u = 0; u < ueNodes.GetN(); ++u) {
-        Ptr<Node> ueNode = ueNodes.Get(u);
-        Ptr<Ipv4StaticRouting> ueStaticRouting = ipv4RoutingHelper.GetStaticRouting(ueNode->GetObject<Ipv4>());
-        ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
-
-        // Downlink: OnOff application from remoteHost -> UE (acts as full-buffer traffic source)
-        if (!disableDl) {
-            OnOffHelper dlClient("ns3::TcpSocketFactory", InetSocketAddress(ueIpIfaces.GetAddress(u), dlPort + u));
-            dlClient.SetAttribute("DataRate", DataRateValue(DataRate("10Gbps")));
-            dlClient.SetAttribute("PacketSize", UintegerValue(1400));
-            // Ensure the OnOff application is always "on" (no idle time) for full buffer traffic
-            dlClient.SetAttribute("OnTime", StringValue("ns3::ConstantRandomVariable[Constant=1]"));
-            dlClient.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0]"));
-            ApplicationContainer dlApps = dlClient.Install(remoteHost);
-            // Sink on UE to receive downlink traffic
-            PacketSinkHelper dlSink("ns3::TcpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), dlPort + u));
-            ApplicationContainer dlSinkApps = dlSink.Install(ueNode);
-            dlApps.Start(Seconds(startVar->GetValue()));
-            dlSinkApps.Start(Seconds(startVar->GetValue()));
-            dlApps.Stop(simTime);
-            dlSinkApps.Stop(simTime);
-        }
-
-        // Uplink: OnOff application from UE -> remoteHost (full-buffer uplink source)
-        if (!disableUl) {
-            OnOffHelper ulClient("ns3::TcpSocketFactory", InetSocketAddress(remoteHostAddr, ulPort + u));
-            ulClient.SetAttribute("DataRate", DataRateValue(DataRate("10Gbps")));
-            ulClient.SetAttribute("PacketSize", UintegerValue(1400));
-            ulClient.SetAttribute("OnTime", StringValue("ns3::ConstantRandomVariable[Constant=1]"));
-            ulClient.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0]"));
-            ApplicationContainer ulApps = ulClient.Install(ueNode);
-            // Sink on remote host to receive uplink traffic
-            PacketSinkHelper ulSink("ns3::TcpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), ulPort + u));
-            ApplicationContainer ulSinkApps = ulSink.Install(remoteHost);
-            ulApps.Start(Seconds(startVar->GetValue()));
-            ulSinkApps.Start(Seconds(startVar->GetValue()));
-            ulApps.Stop(simTime);
-            ulSinkApps.Stop(simTime);
-        }
-    }
-
-    // Enable X2 interface (needed for X2-based handover between eNBs)
-    lteHelper->AddX2Interface(enbNodes);
-
-    // (No manual handover triggers; rely on algorithm-driven handovers)
-
-    //lteHelper->EnablePhyTraces();
-    //lteHelper->EnableMacTraces();
-    //lteHelper->EnableRlcTraces();
-    //lteHelper->EnablePdcpTraces();
-    //Ptr<RadioBearerStatsCalculator> rlcStats = lteHelper->GetRlcStats();
-    //rlcStats->SetAttribute("EpochDuration", TimeValue(Seconds(1.0)));
-    //Ptr<RadioBearerStatsCalculator> pdcpStats = lteHelper->GetPdcpStats();
-    //pdcpStats->SetAttribute("EpochDuration", TimeValue(Seconds(1.0)));
-
-    // Connect custom trace sinks for RRC and handover notifications (logging purposes)
-    Config::Connect("/NodeList/*/DeviceList/*/LteEnbRrc/ConnectionEstablished", MakeCallback(&NotifyConnectionEstablishedEnb));
-    Config::Connect("/NodeList/*/DeviceList/*/LteUeRrc/ConnectionEstablished", MakeCallback(&NotifyConnectionEstablishedUe));
-    Config::Connect("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverStart",        MakeCallback(&NotifyHandoverStartEnb));
-    Config::Connect("/NodeList/*/DeviceList/*/LteUeRrc/HandoverStart",        MakeCallback(&NotifyHandoverStartUe));
-    Config::Connect("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverEndOk",        MakeCallback(&NotifyHandoverEndOkEnb));
-    Config::Connect("/NodeList/*/DeviceList/*/LteUeRrc/HandoverEndOk",        MakeCallback(&NotifyHandoverEndOkUe));
-    Config::Connect("/NodeList/*/DeviceList/*/LteUeRrc/HandoverEndOk",        MakeCallback(&HandoverEndOkCounter));
-    // Trace handover failure events (all reasons) to the same callback
-    Config::Connect("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverFailureNoPreamble", MakeCallback(&NotifyHandoverFailure));
-    Config::Connect("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverFailureMaxRach",    MakeCallback(&NotifyHandoverFailure));
-    Config::Connect("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverFailureLeaving",    MakeCallback(&NotifyHandoverFailure));
-    Config::Connect("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverFailureJoining",    MakeCallback(&NotifyHandoverFailure));
-    // Hook our reporter to the UE measurement trace:
-
-    // Install FlowMonitor on all nodes to collect flow performance statistics
-    FlowMonitorHelper flowmonHelper;
-    Ptr<FlowMonitor> flowmon = flowmonHelper.InstallAll();
-
-    Simulator::Stop(simTime);
-    Simulator::Run();
-
-    // After simulation: gather throughput and handover statistics
-    flowmon->CheckForLostPackets();
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowmonHelper.GetClassifier());
-    std::map<FlowId, FlowMonitor::FlowStats> stats = flowmon->GetFlowStats();
-    uint64_t totalDlBytes = 0;
-    double simulationTimeSeconds = simTime.GetSeconds();
-    for (auto const &flowPair : stats) {
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(flowPair.first);
-        // Sum all downlink flows (remoteHost -> UE) by checking port range
-        if (t.destinationPort >= dlPort && t.destinationPort < dlPort + numberOfUes) {
-            totalDlBytes += flowPair.second.rxBytes;
-        }
-    }
-    double totalThroughputMbps = (totalDlBytes * 8.0) / (simulationTimeSeconds * 1e6);
-    std::cout << "Total Downlink Throughput: " << totalThroughputMbps << " Mbps" << std::endl;
-
-    // Calculate Average Number of Handover (ANOH) and Optimize Ratio as defined in the paper
-    double anoh = 0.0;
-    if (numberOfUes > 0 && simulationTimeSeconds > 0) {
-        anoh = (double) g_handoverCount / (numberOfUes * simulationTimeSeconds);
-    }
-    std::cout << "ANOH (Avg handovers per UE per second): " << anoh << std::endl;
-    if (anoh > 0.0) {
-        double optimizeRatio = totalThroughputMbps / anoh;
-        std::cout << "Optimization Ratio (Throughput/ANOH): " << optimizeRatio << std::endl;
-    } else {
-        std::cout << "Optimization Ratio: N/A (no handovers occurred)" << std::endl;
-    }
-
-    Simulator::Destroy();
-    return 0;
-}
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/lte-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/cosine-antenna-model.h"
+#include "ns3/lte-enb-phy.h"
+#include "ns3/lte-radio-bearer-info.h"
+#include "ns3/lte-rlc.h"
+#include "ns3/spectrum-propagation-loss-model.h"
+#include "ns3/trace-fading-loss-model.h"
+
+#include <cxxabi.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <typeinfo>
+#include <unordered_map>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LenaHandoverSimulation");
+
+// Global counter for successful handovers
+static uint32_t g_handoverCount = 0;
+
+// Callback to count each completed handover event
+void HandoverEndOkCounter(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    g_handoverCount++;
+}
+
+// UEs that completed their first RRC connection, and when the last of the
+// run's UEs did (sim time; -1 until then) and at which wall-clock time
+static std::set<uint64_t> g_connectedUes;
+static uint32_t g_expectedUes = 0;
+static double g_allConnectedSeconds = -1.0;
+static std::chrono::steady_clock::time_point g_allConnectedWall;
+
+void ConnectionEstablishedCounter(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    if (g_connectedUes.insert(imsi).second && g_connectedUes.size() == g_expectedUes) {
+        g_allConnectedSeconds = Simulator::Now().GetSeconds();
+        g_allConnectedWall = std::chrono::steady_clock::now();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Connection / handover event logging
+//
+// Every RRC trace is turned into a fixed-size EventRecord. In text mode the
+// record is formatted straight to stdout; with --eventLog it is pushed into
+// a preallocated ring buffer that a background thread drains to a binary
+// file, which --decodeEvents turns back into the same text.
+// ---------------------------------------------------------------------------
+
+enum EventType : uint8_t {
+    EVENT_CONNECTION_ESTABLISHED_UE = 0,
+    EVENT_CONNECTION_ESTABLISHED_ENB,
+    EVENT_HANDOVER_START_UE,
+    EVENT_HANDOVER_START_ENB,
+    EVENT_HANDOVER_END_OK_UE,
+    EVENT_HANDOVER_END_OK_ENB,
+    EVENT_HANDOVER_FAILURE
+};
+
+enum HandoverFailureReason : uint8_t {
+    FAILURE_NONE = 0,
+    FAILURE_NO_PREAMBLE,
+    FAILURE_MAX_RACH,
+    FAILURE_LEAVING,
+    FAILURE_JOINING
+};
+
+struct EventRecord {
+    int64_t timeNs;
+    uint64_t imsi;
+    uint32_t nodeId;        // node/device of the traced RRC, used to rebuild the trace context
+    uint16_t cellId;
+    uint16_t targetCellId;  // handover start only
+    uint16_t rnti;
+    uint8_t type;           // EventType
+    uint8_t reason;         // HandoverFailureReason
+    uint8_t deviceId;
+    uint8_t padding[3];
+};
+static_assert(sizeof(EventRecord) == 32, "EventRecord must stay a fixed 32-byte record");
+
+struct EventLogHeader {
+    char magic[4];  // "HOEV"
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+// Single-producer (simulator thread) / single-consumer (writer thread) ring buffer
+class EventRecorder {
+public:
+    EventRecorder(const std::string &fileName, uint32_t capacity) {
+        // Round up to a power of two so the ring index is a mask
+        m_capacity = 1;
+        while (m_capacity < capacity) {
+            m_capacity <<= 1;
+        }
+        m_buffer.resize(m_capacity);
+        m_fileName = fileName;
+        m_file = fopen(fileName.c_str(), "wb");
+        NS_ABORT_MSG_IF(!m_file, "Cannot open event log " << fileName);
+        EventLogHeader header = {{'H', 'O', 'E', 'V'}, 1, sizeof(EventRecord), 0};
+        NS_ABORT_MSG_IF(fwrite(&header, sizeof(header), 1, m_file) != 1, "Cannot write event log " << fileName);
+        m_writer = std::thread(&EventRecorder::WriterLoop, this);
+    }
+
+    ~EventRecorder() {
+        Stop();
+    }
+
+    void Push(const EventRecord &record) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        // Buffer full: sleep until the writer has made room rather than drop records
+        if (head - m_tail.load(std::memory_order_acquire) >= m_capacity) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.notify_one();
+            m_space.wait(lock, [&]() { return head - m_tail.load(std::memory_order_acquire) < m_capacity; });
+        }
+        m_buffer[head & (m_capacity - 1)] = record;
+        m_head.store(head + 1, std::memory_order_release);
+        if (head - m_tail.load(std::memory_order_relaxed) == m_capacity / 2) {
+            m_wake.notify_one();
+        }
+    }
+
+    // Drain everything still buffered and close the file
+    void Stop() {
+        if (!m_writer.joinable()) {
+            return;
+        }
+        m_stopping.store(true);
+        m_wake.notify_one();
+        m_writer.join();
+        bool ok = fclose(m_file) == 0 && !m_writeFailed;
+        NS_ABORT_MSG_IF(!ok, "Failed to write event log " << m_fileName);
+    }
+
+private:
+    void WriterLoop() {
+        while (true) {
+            uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            uint64_t head = m_head.load(std::memory_order_acquire);
+            if (head == tail) {
+                if (m_stopping.load() && m_head.load(std::memory_order_acquire) == tail) {
+                    break;
+                }
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait_for(lock, std::chrono::milliseconds(20));
+                continue;
+            }
+            // Write the contiguous run up to the end of the ring in one call
+            uint64_t begin = tail & (m_capacity - 1);
+            uint64_t count = std::min<uint64_t>(head - tail, m_capacity - begin);
+            m_writeFailed |= fwrite(&m_buffer[begin], sizeof(EventRecord), count, m_file) != count;
+            {
+                // Under the lock, so a producer about to wait cannot miss the wakeup
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tail.store(tail + count, std::memory_order_release);
+            }
+            m_space.notify_one();
+        }
+    }
+
+    std::vector<EventRecord> m_buffer;
+    uint64_t m_capacity;
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<uint64_t> m_tail{0};
+    std::atomic<bool> m_stopping{false};
+    std::mutex m_mutex;
+    std::condition_variable m_wake;   // writer: records to write or stop
+    std::condition_variable m_space;  // producer: room in a full buffer
+    std::thread m_writer;
+    std::string m_fileName;
+    FILE *m_file;
+    bool m_writeFailed = false;  // writer thread only until joined
+};
+
+static std::unique_ptr<EventRecorder> g_eventRecorder;
+
+// Print a record in the console format of the original per-event logging
+void FormatEvent(std::ostream &os, const EventRecord &record) {
+    static const char *const traceNames[] = {
+        "LteUeRrc/ConnectionEstablished", "LteEnbRrc/ConnectionEstablished",
+        "LteUeRrc/HandoverStart",         "LteEnbRrc/HandoverStart",
+        "LteUeRrc/HandoverEndOk",         "LteEnbRrc/HandoverEndOk",
+        "LteEnbRrc/HandoverFailure"};
+    static const char *const failureNames[] = {"", "NoPreamble", "MaxRach", "Leaving", "Joining"};
+    if (record.type > EVENT_HANDOVER_FAILURE || record.reason > FAILURE_JOINING) {
+        return;
+    }
+
+    os << NanoSeconds(record.timeNs).As(Time::S) << " /NodeList/" << record.nodeId
+       << "/DeviceList/" << (uint32_t)record.deviceId << "/" << traceNames[record.type]
+       << failureNames[record.reason];
+    switch (record.type) {
+    case EVENT_CONNECTION_ESTABLISHED_UE:
+        os << " UE IMSI " << record.imsi << ": connected to CellId "
+           << record.cellId << " with RNTI " << record.rnti;
+        break;
+    case EVENT_CONNECTION_ESTABLISHED_ENB:
+        os << " eNB CellId " << record.cellId << ": UE IMSI " << record.imsi
+           << " connected with RNTI " << record.rnti;
+        break;
+    case EVENT_HANDOVER_START_UE:
+        os << " UE IMSI " << record.imsi << ": starting handover from CellId "
+           << record.cellId << " to CellId " << record.targetCellId;
+        break;
+    case EVENT_HANDOVER_START_ENB:
+        os << " eNB CellId " << record.cellId << ": initiating handover of UE IMSI "
+           << record.imsi << " to CellId " << record.targetCellId;
+        break;
+    case EVENT_HANDOVER_END_OK_UE:
+        os << " UE IMSI " << record.imsi << ": completed handover to CellId " << record.cellId;
+        break;
+    case EVENT_HANDOVER_END_OK_ENB:
+        os << " eNB CellId " << record.cellId << ": successful handover of UE IMSI " << record.imsi;
+        break;
+    case EVENT_HANDOVER_FAILURE:
+        os << " eNB CellId " << record.cellId << " IMSI " << record.imsi
+           << " handover failure (RNTI " << record.rnti << ")";
+        break;
+    }
+    os << "\n";
+}
+
+void LogEvent(uint32_t nodeId, uint32_t deviceId, EventType type, uint64_t imsi, uint16_t cellId,
+              uint16_t rnti, uint16_t targetCellId = 0, HandoverFailureReason reason = FAILURE_NONE) {
+    EventRecord record = {};
+    record.timeNs = Simulator::Now().GetNanoSeconds();
+    record.imsi = imsi;
+    record.nodeId = nodeId;
+    record.cellId = cellId;
+    record.targetCellId = targetCellId;
+    record.rnti = rnti;
+    record.type = type;
+    record.reason = reason;
+    record.deviceId = static_cast<uint8_t>(deviceId);
+    if (g_eventRecorder) {
+        g_eventRecorder->Push(record);
+    } else {
+        FormatEvent(std::cout, record);
+    }
+}
+
+// Trace callbacks for connection and handover events (for logging); node and
+// device ids are bound at connect time instead of building a context string
+void NotifyConnectionEstablishedUe(uint32_t nodeId, uint32_t deviceId, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    LogEvent(nodeId, deviceId, EVENT_CONNECTION_ESTABLISHED_UE, imsi, cellId, rnti);
+}
+void NotifyHandoverStartUe(uint32_t nodeId, uint32_t deviceId, uint64_t imsi, uint16_t cellId,
+                           uint16_t rnti, uint16_t targetCellId) {
+    LogEvent(nodeId, deviceId, EVENT_HANDOVER_START_UE, imsi, cellId, rnti, targetCellId);
+}
+void NotifyHandoverEndOkUe(uint32_t nodeId, uint32_t deviceId, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    LogEvent(nodeId, deviceId, EVENT_HANDOVER_END_OK_UE, imsi, cellId, rnti);
+}
+void NotifyConnectionEstablishedEnb(uint32_t nodeId, uint32_t deviceId, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    LogEvent(nodeId, deviceId, EVENT_CONNECTION_ESTABLISHED_ENB, imsi, cellId, rnti);
+}
+void NotifyHandoverStartEnb(uint32_t nodeId, uint32_t deviceId, uint64_t imsi, uint16_t cellId,
+                            uint16_t rnti, uint16_t targetCellId) {
+    LogEvent(nodeId, deviceId, EVENT_HANDOVER_START_ENB, imsi, cellId, rnti, targetCellId);
+}
+void NotifyHandoverEndOkEnb(uint32_t nodeId, uint32_t deviceId, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    LogEvent(nodeId, deviceId, EVENT_HANDOVER_END_OK_ENB, imsi, cellId, rnti);
+}
+// The HandoverFailure* traces report (imsi, rnti, cellId)
+void NotifyHandoverFailure(uint32_t nodeId, uint32_t deviceId, HandoverFailureReason reason,
+                           uint64_t imsi, uint16_t rnti, uint16_t cellId) {
+    LogEvent(nodeId, deviceId, EVENT_HANDOVER_FAILURE, imsi, cellId, rnti, 0, reason);
+}
+
+// Offline decoder: print a binary event log in the console text format
+int DecodeEventLog(const std::string &fileName) {
+    FILE *file = fopen(fileName.c_str(), "rb");
+    NS_ABORT_MSG_IF(!file, "Cannot open event log " << fileName);
+    EventLogHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 std::memcmp(header.magic, "HOEV", 4) == 0 && header.recordSize == sizeof(EventRecord);
+    NS_ABORT_MSG_IF(!valid, fileName << " is not an event log written by this version");
+    std::vector<EventRecord> records(4096);
+    size_t n;
+    while ((n = fread(records.data(), sizeof(EventRecord), records.size(), file)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            FormatEvent(std::cout, records[i]);
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+// Hook the logging callbacks directly on each device's RRC
+void ConnectEventLogging(const NetDeviceContainer &enbDevs, const NetDeviceContainer &ueDevs) {
+    for (uint32_t i = 0; i < ueDevs.GetN(); ++i) {
+        uint32_t nodeId = ueDevs.Get(i)->GetNode()->GetId();
+        uint32_t deviceId = ueDevs.Get(i)->GetIfIndex();
+        Ptr<LteUeRrc> rrc = ueDevs.Get(i)->GetObject<LteUeNetDevice>()->GetRrc();
+        rrc->TraceConnectWithoutContext("ConnectionEstablished", MakeBoundCallback(&NotifyConnectionEstablishedUe, nodeId, deviceId));
+        rrc->TraceConnectWithoutContext("HandoverStart",         MakeBoundCallback(&NotifyHandoverStartUe, nodeId, deviceId));
+        rrc->TraceConnectWithoutContext("HandoverEndOk",         MakeBoundCallback(&NotifyHandoverEndOkUe, nodeId, deviceId));
+    }
+    for (uint32_t i = 0; i < enbDevs.GetN(); ++i) {
+        uint32_t nodeId = enbDevs.Get(i)->GetNode()->GetId();
+        uint32_t deviceId = enbDevs.Get(i)->GetIfIndex();
+        Ptr<LteEnbRrc> rrc = enbDevs.Get(i)->GetObject<LteEnbNetDevice>()->GetRrc();
+        rrc->TraceConnectWithoutContext("ConnectionEstablished", MakeBoundCallback(&NotifyConnectionEstablishedEnb, nodeId, deviceId));
+        rrc->TraceConnectWithoutContext("HandoverStart",         MakeBoundCallback(&NotifyHandoverStartEnb, nodeId, deviceId));
+        rrc->TraceConnectWithoutContext("HandoverEndOk",         MakeBoundCallback(&NotifyHandoverEndOkEnb, nodeId, deviceId));
+        // Trace handover failure events (all reasons) to the same callback
+        rrc->TraceConnectWithoutContext("HandoverFailureNoPreamble", MakeBoundCallback(&NotifyHandoverFailure, nodeId, deviceId, FAILURE_NO_PREAMBLE));
+        rrc->TraceConnectWithoutContext("HandoverFailureMaxRach",    MakeBoundCallback(&NotifyHandoverFailure, nodeId, deviceId, FAILURE_MAX_RACH));
+        rrc->TraceConnectWithoutContext("HandoverFailureLeaving",    MakeBoundCallback(&NotifyHandoverFailure, nodeId, deviceId, FAILURE_LEAVING));
+        rrc->TraceConnectWithoutContext("HandoverFailureJoining",    MakeBoundCallback(&NotifyHandoverFailure, nodeId, deviceId, FAILURE_JOINING));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Handover analytics
+//
+// Per-UE state lives in a preallocated array indexed by IMSI and per-cell
+// counters in one indexed by CellId, so every trace event is O(1) with no
+// allocation. Definitions:
+//   ping-pong   A -> B -> A with less than --pingPongWindow spent in B
+//   too late    radio link failure, then reconnection to another cell, with
+//               no handover in the preceding --rlfWindow (counted at the
+//               failed cell)
+//   too early   radio link failure within --rlfWindow of a handover, then
+//               reconnection to the handover source (counted at the source)
+//   wrong cell  as too early, but reconnection to a third cell
+//   interruption  UE HandoverStart -> HandoverEndOk
+//   time of stay  connection or handover into a cell -> leaving it; stays
+//               still open at the end of the run are not counted
+// ---------------------------------------------------------------------------
+
+class HandoverAnalytics {
+public:
+    static const uint32_t kInterruptionBuckets = 1000;  // 1 ms histogram buckets, last one open-ended
+
+    HandoverAnalytics(const std::vector<uint64_t> &imsis, uint32_t numberOfCells, Time pingPongWindow, Time rlfWindow)
+        : m_ues(imsis.empty() ? 1 : *std::max_element(imsis.begin(), imsis.end()) + 1), m_cells(numberOfCells + 1),
+          m_interruptionHistogram(kInterruptionBuckets, 0),
+          m_pingPongWindowNs(pingPongWindow.GetNanoSeconds()), m_rlfWindowNs(rlfWindow.GetNanoSeconds()) {
+    }
+
+    void ConnectionEstablished(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        UeState &ue = m_ues[imsi];
+        if (ue.rlfNs >= 0) {
+            // Back after a radio link failure: classify it by where the UE reconnects
+            if (ue.lastHandoverNs >= 0 && ue.rlfNs - ue.lastHandoverNs <= m_rlfWindowNs) {
+                if (cellId == ue.previousCell) {
+                    ++Cell(ue.previousCell).tooEarly;
+                } else if (cellId != ue.rlfCell) {
+                    ++Cell(ue.previousCell).wrongCell;
+                }
+            } else if (cellId != ue.rlfCell) {
+                ++Cell(ue.rlfCell).tooLate;
+            }
+            ue.rlfNs = -1;
+        }
+        ue.servingCell = cellId;
+        ue.previousCell = 0;
+        ue.lastHandoverNs = -1;
+        ue.cellEntryNs = now;
+    }
+
+    void HandoverStart(uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId) {
+        m_ues[imsi].handoverStartNs = Simulator::Now().GetNanoSeconds();
+    }
+
+    void HandoverEndOk(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        UeState &ue = m_ues[imsi];
+        if (ue.handoverStartNs >= 0) {
+            int64_t interruption = now - ue.handoverStartNs;
+            m_interruptionSumNs += interruption;
+            m_interruptionMaxNs = std::max(m_interruptionMaxNs, interruption);
+            ++m_interruptionHistogram[std::min<int64_t>(interruption / 1000000, kInterruptionBuckets - 1)];
+            ++m_interruptions;
+            ue.handoverStartNs = -1;
+        }
+        uint16_t source = ue.servingCell;
+        CloseStay(ue, now);
+        ++Cell(source).handoversOut;
+        ++Cell(cellId).handoversIn;
+        ++m_handovers;
+        if (cellId == ue.previousCell && now - ue.lastHandoverNs <= m_pingPongWindowNs) {
+            ++Cell(source).pingPongs;
+        }
+        ue.previousCell = source;
+        ue.servingCell = cellId;
+        ue.lastHandoverNs = now;
+        ue.cellEntryNs = now;
+    }
+
+    void RadioLinkFailure(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        UeState &ue = m_ues[imsi];
+        CloseStay(ue, now);
+        ++Cell(cellId).radioLinkFailures;
+        ue.rlfNs = now;
+        ue.rlfCell = cellId;
+        ue.servingCell = 0;
+        ue.handoverStartNs = -1;
+    }
+
+    // eNB side HandoverFailure* traces report (imsi, rnti, cellId)
+    void HandoverFailure(HandoverFailureReason reason, uint64_t imsi, uint16_t rnti, uint16_t cellId) {
+        ++Cell(cellId).failures[reason];
+        if (imsi < m_ues.size()) {
+            m_ues[imsi].handoverStartNs = -1;
+        }
+    }
+
+    // Zero every counter but keep the per-UE state (warm-start branches)
+    void ResetCounters() {
+        std::fill(m_cells.begin(), m_cells.end(), CellCounters());
+        std::fill(m_interruptionHistogram.begin(), m_interruptionHistogram.end(), 0);
+        m_handovers = 0;
+        m_interruptions = 0;
+        m_interruptionSumNs = 0;
+        m_interruptionMaxNs = 0;
+    }
+
+    uint32_t GetHandovers() const {
+        return m_handovers;
+    }
+    uint32_t GetPingPongs() const {
+        return Sum(&CellCounters::pingPongs);
+    }
+    uint32_t GetTooEarly() const {
+        return Sum(&CellCounters::tooEarly);
+    }
+    uint32_t GetTooLate() const {
+        return Sum(&CellCounters::tooLate);
+    }
+    uint32_t GetFailures(HandoverFailureReason reason) const {
+        uint32_t total = 0;
+        for (auto const &cell : m_cells) {
+            total += cell.failures[reason];
+        }
+        return total;
+    }
+    uint32_t GetFailures() const {
+        return GetFailures(FAILURE_NO_PREAMBLE) + GetFailures(FAILURE_MAX_RACH) + GetFailures(FAILURE_LEAVING) +
+               GetFailures(FAILURE_JOINING);
+    }
+    double GetMeanInterruptionMs() const {
+        return m_interruptions > 0 ? m_interruptionSumNs / 1e6 / m_interruptions : 0.0;
+    }
+
+    void Print(std::ostream &os) const {
+        uint32_t pingPongs = GetPingPongs();
+        os << "Handovers: " << m_handovers << " (ping-pong " << pingPongs << ", "
+           << (m_handovers > 0 ? 100.0 * pingPongs / m_handovers : 0.0) << "%)" << std::endl;
+        os << "Handover failures: NoPreamble " << GetFailures(FAILURE_NO_PREAMBLE) << ", MaxRach "
+           << GetFailures(FAILURE_MAX_RACH) << ", Leaving " << GetFailures(FAILURE_LEAVING) << ", Joining "
+           << GetFailures(FAILURE_JOINING) << std::endl;
+        os << "Radio link failures: " << Sum(&CellCounters::radioLinkFailures) << " (too late " << GetTooLate()
+           << ", too early " << GetTooEarly() << ", wrong cell " << Sum(&CellCounters::wrongCell) << ")" << std::endl;
+        os << "Handover interruption: mean " << GetMeanInterruptionMs() << " ms, p95 " << InterruptionPercentileMs(0.95)
+           << " ms, max " << m_interruptionMaxNs / 1e6 << " ms" << std::endl;
+        uint32_t stays = Sum(&CellCounters::stays);
+        int64_t stayNs = 0;
+        for (auto const &cell : m_cells) {
+            stayNs += cell.stayNs;
+        }
+        os << "Mean time of stay: " << (stays > 0 ? stayNs / 1e9 / stays : 0.0) << " s over " << stays << " stays"
+           << std::endl;
+    }
+
+    // One CSV row per cell
+    void WriteCellTable(const std::string &fileName) const {
+        std::ofstream out(fileName);
+        NS_ABORT_MSG_IF(!out, "Cannot open handover statistics file " << fileName);
+        out << "cellId,handoversIn,handoversOut,pingPongs,failNoPreamble,failMaxRach,failLeaving,failJoining,"
+               "radioLinkFailures,tooLate,tooEarly,wrongCell,stays,meanStaySeconds\n";
+        for (uint32_t id = 1; id < m_cells.size(); ++id) {
+            const CellCounters &cell = m_cells[id];
+            out << id << "," << cell.handoversIn << "," << cell.handoversOut << "," << cell.pingPongs << ","
+                << cell.failures[FAILURE_NO_PREAMBLE] << "," << cell.failures[FAILURE_MAX_RACH] << ","
+                << cell.failures[FAILURE_LEAVING] << "," << cell.failures[FAILURE_JOINING] << ","
+                << cell.radioLinkFailures << "," << cell.tooLate << "," << cell.tooEarly << "," << cell.wrongCell
+                << "," << cell.stays << "," << (cell.stays > 0 ? cell.stayNs / 1e9 / cell.stays : 0.0) << "\n";
+        }
+    }
+
+private:
+    struct UeState {
+        int64_t cellEntryNs = 0;
+        int64_t lastHandoverNs = -1;
+        int64_t handoverStartNs = -1;
+        int64_t rlfNs = -1;
+        uint16_t servingCell = 0;   // 0 = not connected
+        uint16_t previousCell = 0;  // source of the last handover
+        uint16_t rlfCell = 0;
+    };
+
+    struct CellCounters {
+        uint32_t handoversIn = 0;
+        uint32_t handoversOut = 0;
+        uint32_t pingPongs = 0;
+        uint32_t failures[FAILURE_JOINING + 1] = {};
+        uint32_t radioLinkFailures = 0;
+        uint32_t tooLate = 0;
+        uint32_t tooEarly = 0;
+        uint32_t wrongCell = 0;
+        uint32_t stays = 0;
+        int64_t stayNs = 0;
+    };
+
+    // Unknown cell ids land in slot 0 instead of growing the table
+    CellCounters &Cell(uint16_t cellId) {
+        return m_cells[cellId < m_cells.size() ? cellId : 0];
+    }
+
+    void CloseStay(const UeState &ue, int64_t now) {
+        if (ue.servingCell != 0) {
+            CellCounters &cell = Cell(ue.servingCell);
+            cell.stayNs += now - ue.cellEntryNs;
+            ++cell.stays;
+        }
+    }
+
+    uint32_t Sum(uint32_t CellCounters::*counter) const {
+        uint32_t total = 0;
+        for (auto const &cell : m_cells) {
+            total += cell.*counter;
+        }
+        return total;
+    }
+
+    double InterruptionPercentileMs(double p) const {
+        uint64_t target = static_cast<uint64_t>(std::ceil(p * m_interruptions));
+        uint64_t seen = 0;
+        for (uint32_t ms = 0; ms < kInterruptionBuckets; ++ms) {
+            seen += m_interruptionHistogram[ms];
+            if (seen >= target && seen > 0) {
+                return std::min(ms + 1.0, m_interruptionMaxNs / 1e6);  // upper edge of the bucket
+            }
+        }
+        return 0.0;
+    }
+
+    std::vector<UeState> m_ues;
+    std::vector<CellCounters> m_cells;
+    std::vector<uint32_t> m_interruptionHistogram;
+    int64_t m_pingPongWindowNs;
+    int64_t m_rlfWindowNs;
+    uint32_t m_handovers = 0;
+    uint32_t m_interruptions = 0;
+    int64_t m_interruptionSumNs = 0;
+    int64_t m_interruptionMaxNs = 0;
+};
+
+static std::unique_ptr<HandoverAnalytics> g_handoverAnalytics;
+
+void AnalyticsConnectionEstablished(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    g_handoverAnalytics->ConnectionEstablished(imsi, cellId, rnti);
+}
+void AnalyticsHandoverStart(uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId) {
+    g_handoverAnalytics->HandoverStart(imsi, cellId, rnti, targetCellId);
+}
+void AnalyticsHandoverEndOk(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    g_handoverAnalytics->HandoverEndOk(imsi, cellId, rnti);
+}
+void AnalyticsRadioLinkFailure(uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    g_handoverAnalytics->RadioLinkFailure(imsi, cellId, rnti);
+}
+void AnalyticsHandoverFailure(HandoverFailureReason reason, uint64_t imsi, uint16_t rnti, uint16_t cellId) {
+    g_handoverAnalytics->HandoverFailure(reason, imsi, rnti, cellId);
+}
+
+void ConnectHandoverAnalytics(const NetDeviceContainer &enbDevs, const NetDeviceContainer &ueDevs) {
+    for (uint32_t i = 0; i < ueDevs.GetN(); ++i) {
+        Ptr<LteUeRrc> rrc = ueDevs.Get(i)->GetObject<LteUeNetDevice>()->GetRrc();
+        rrc->TraceConnectWithoutContext("ConnectionEstablished", MakeCallback(&AnalyticsConnectionEstablished));
+        rrc->TraceConnectWithoutContext("HandoverStart",         MakeCallback(&AnalyticsHandoverStart));
+        rrc->TraceConnectWithoutContext("HandoverEndOk",         MakeCallback(&AnalyticsHandoverEndOk));
+        rrc->TraceConnectWithoutContext("RadioLinkFailure",      MakeCallback(&AnalyticsRadioLinkFailure));
+    }
+    for (uint32_t i = 0; i < enbDevs.GetN(); ++i) {
+        Ptr<LteEnbRrc> rrc = enbDevs.Get(i)->GetObject<LteEnbNetDevice>()->GetRrc();
+        rrc->TraceConnectWithoutContext("HandoverFailureNoPreamble", MakeBoundCallback(&AnalyticsHandoverFailure, FAILURE_NO_PREAMBLE));
+        rrc->TraceConnectWithoutContext("HandoverFailureMaxRach",    MakeBoundCallback(&AnalyticsHandoverFailure, FAILURE_MAX_RACH));
+        rrc->TraceConnectWithoutContext("HandoverFailureLeaving",    MakeBoundCallback(&AnalyticsHandoverFailure, FAILURE_LEAVING));
+        rrc->TraceConnectWithoutContext("HandoverFailureJoining",    MakeBoundCallback(&AnalyticsHandoverFailure, FAILURE_JOINING));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Streaming KPI collector
+//
+// Hooks only the UE downlink sinks and the remote host uplink sinks. Every
+// --kpiInterval it writes one row per UE (bytes received since the previous
+// sample, tagged with the serving cell) and one row per cell (imsi = 0) to a
+// columnar file. Rows are buffered one block at a time, so memory does not
+// grow with simTime.
+//
+// File layout: KpiFileHeader, then blocks of
+//   uint32 rows | uint32 timeMs[rows] | uint32 imsi[rows] | uint16 cellId[rows]
+//   | uint32 dlBytes[rows] | uint32 ulBytes[rows]
+// ---------------------------------------------------------------------------
+
+struct KpiFileHeader {
+    char magic[4];  // "KPIC"
+    uint32_t version;
+    uint32_t intervalMs;
+    uint32_t blockRows;
+};
+
+class KpiCollector {
+public:
+    static const uint32_t kBlockRows = 4096;
+
+    KpiCollector(const std::string &fileName, Time interval, const std::vector<uint64_t> &imsis, uint32_t numberOfCells)
+        : m_interval(interval), m_imsis(imsis), m_dlBytes(imsis.size(), 0), m_ulBytes(imsis.size(), 0),
+          m_lastDlBytes(imsis.size(), 0), m_lastUlBytes(imsis.size(), 0), m_servingCell(imsis.size(), 0),
+          m_cellDlBytes(numberOfCells + 1, 0), m_cellUlBytes(numberOfCells + 1, 0), m_file(nullptr) {
+        if (fileName.empty()) {
+            return;  // totals only (used when FlowMonitor is off)
+        }
+        m_file = fopen(fileName.c_str(), "wb");
+        NS_ABORT_MSG_IF(!m_file, "Cannot open KPI file " << fileName);
+        KpiFileHeader header = {{'K', 'P', 'I', 'C'}, 1, static_cast<uint32_t>(interval.GetMilliSeconds()), kBlockRows};
+        fwrite(&header, sizeof(header), 1, m_file);
+        m_time.reserve(kBlockRows);
+        m_imsi.reserve(kBlockRows);
+        m_cell.reserve(kBlockRows);
+        m_dl.reserve(kBlockRows);
+        m_ul.reserve(kBlockRows);
+        Simulator::Schedule(m_interval, &KpiCollector::Sample, this);
+    }
+
+    ~KpiCollector() {
+        Close();
+    }
+
+    void RxDl(uint32_t ue, uint32_t bytes) {
+        m_dlBytes[ue] += bytes;
+    }
+    void RxUl(uint32_t ue, uint32_t bytes) {
+        m_ulBytes[ue] += bytes;
+    }
+    void SetServingCell(uint32_t ue, uint16_t cellId) {
+        m_servingCell[ue] = cellId;
+    }
+
+    uint64_t GetTotalDlBytes() const {
+        return std::accumulate(m_dlBytes.begin(), m_dlBytes.end(), uint64_t(0));
+    }
+
+    // Write out buffered rows, e.g. before fork() so children do not duplicate them
+    void Flush() {
+        if (m_file) {
+            FlushBlock();
+            fflush(m_file);
+        }
+    }
+
+    // Continue the time series in a new file (warm-start branch children)
+    void Reopen(const std::string &fileName) {
+        Close();
+        m_file = fopen(fileName.c_str(), "wb");
+        NS_ABORT_MSG_IF(!m_file, "Cannot open KPI file " << fileName);
+        KpiFileHeader header = {{'K', 'P', 'I', 'C'}, 1, static_cast<uint32_t>(m_interval.GetMilliSeconds()), kBlockRows};
+        fwrite(&header, sizeof(header), 1, m_file);
+    }
+
+    // Flush the last partial block and close the file
+    void Close() {
+        if (m_file) {
+            FlushBlock();
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+private:
+    void Sample() {
+        uint32_t timeMs = static_cast<uint32_t>(Simulator::Now().GetMilliSeconds());
+        std::fill(m_cellDlBytes.begin(), m_cellDlBytes.end(), 0);
+        std::fill(m_cellUlBytes.begin(), m_cellUlBytes.end(), 0);
+        for (uint32_t ue = 0; ue < m_imsis.size(); ++ue) {
+            uint32_t dl = static_cast<uint32_t>(m_dlBytes[ue] - m_lastDlBytes[ue]);
+            uint32_t ul = static_cast<uint32_t>(m_ulBytes[ue] - m_lastUlBytes[ue]);
+            m_lastDlBytes[ue] = m_dlBytes[ue];
+            m_lastUlBytes[ue] = m_ulBytes[ue];
+            uint16_t cellId = m_servingCell[ue];
+            if (cellId < m_cellDlBytes.size()) {
+                m_cellDlBytes[cellId] += dl;
+                m_cellUlBytes[cellId] += ul;
+            }
+            AppendRow(timeMs, static_cast<uint32_t>(m_imsis[ue]), cellId, dl, ul);
+        }
+        for (uint16_t cellId = 1; cellId < m_cellDlBytes.size(); ++cellId) {
+            AppendRow(timeMs, 0, cellId, static_cast<uint32_t>(m_cellDlBytes[cellId]),
+                      static_cast<uint32_t>(m_cellUlBytes[cellId]));
+        }
+        Simulator::Schedule(m_interval, &KpiCollector::Sample, this);
+    }
+
+    void AppendRow(uint32_t timeMs, uint32_t imsi, uint16_t cellId, uint32_t dl, uint32_t ul) {
+        m_time.push_back(timeMs);
+        m_imsi.push_back(imsi);
+        m_cell.push_back(cellId);
+        m_dl.push_back(dl);
+        m_ul.push_back(ul);
+        if (m_time.size() == kBlockRows) {
+            FlushBlock();
+        }
+    }
+
+    void FlushBlock() {
+        uint32_t rows = m_time.size();
+        if (rows == 0) {
+            return;
+        }
+        fwrite(&rows, sizeof(rows), 1, m_file);
+        fwrite(m_time.data(), sizeof(uint32_t), rows, m_file);
+        fwrite(m_imsi.data(), sizeof(uint32_t), rows, m_file);
+        fwrite(m_cell.data(), sizeof(uint16_t), rows, m_file);
+        fwrite(m_dl.data(), sizeof(uint32_t), rows, m_file);
+        fwrite(m_ul.data(), sizeof(uint32_t), rows, m_file);
+        m_time.clear();
+        m_imsi.clear();
+        m_cell.clear();
+        m_dl.clear();
+        m_ul.clear();
+    }
+
+    Time m_interval;
+    std::vector<uint64_t> m_imsis;  // indexed by UE index
+    std::vector<uint64_t> m_dlBytes;
+    std::vector<uint64_t> m_ulBytes;
+    std::vector<uint64_t> m_lastDlBytes;
+    std::vector<uint64_t> m_lastUlBytes;
+    std::vector<uint16_t> m_servingCell;
+    std::vector<uint64_t> m_cellDlBytes;  // indexed by CellId, scratch for one sample
+    std::vector<uint64_t> m_cellUlBytes;
+    // Column buffers of the block being filled
+    std::vector<uint32_t> m_time;
+    std::vector<uint32_t> m_imsi;
+    std::vector<uint16_t> m_cell;
+    std::vector<uint32_t> m_dl;
+    std::vector<uint32_t> m_ul;
+    FILE *m_file;
+};
+
+static std::unique_ptr<KpiCollector> g_kpiCollector;
+
+void KpiDlRx(uint32_t ue, Ptr<const Packet> packet, const Address &from) {
+    g_kpiCollector->RxDl(ue, packet->GetSize());
+}
+void KpiUlRx(uint32_t ue, Ptr<const Packet> packet, const Address &from) {
+    g_kpiCollector->RxUl(ue, packet->GetSize());
+}
+void KpiServingCell(uint32_t ue, uint64_t imsi, uint16_t cellId, uint16_t rnti) {
+    g_kpiCollector->SetServingCell(ue, cellId);
+}
+
+// RLC-layer downlink bytes (saturated bearers, or rlcThroughput with TCP): the UE-side
+// RLC entity of every DRB reports its received PDUs. A handover clears the DRB map and
+// rebuilds the DRBs, so the new RLC of each DrbCreated lcid is hooked as it is created;
+// nothing keeps the old RLCs alive.
+void KpiRlcRx(uint32_t ue, uint16_t rnti, uint8_t lcid, uint32_t bytes, uint64_t delay) {
+    g_kpiCollector->RxDl(ue, bytes);
+}
+void KpiRlcDrbCreated(uint32_t ue, LteUeRrc *rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti, uint8_t lcid) {
+    ObjectMapValue drbs;
+    rrc->GetAttribute("DataRadioBearerMap", drbs);
+    for (auto it = drbs.Begin(); it != drbs.End(); ++it) {
+        Ptr<LteDataRadioBearerInfo> drb = DynamicCast<LteDataRadioBearerInfo>(it->second);
+        if (drb->m_logicalChannelIdentity == lcid) {
+            drb->m_rlc->TraceConnectWithoutContext("RxPDU", MakeBoundCallback(&KpiRlcRx, ue));
+        }
+    }
+}
+
+// Offline decoder: print a KPI file as CSV
+int DecodeKpiFile(const std::string &fileName) {
+    FILE *file = fopen(fileName.c_str(), "rb");
+    NS_ABORT_MSG_IF(!file, "Cannot open KPI file " << fileName);
+    KpiFileHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && std::memcmp(header.magic, "KPIC", 4) == 0;
+    NS_ABORT_MSG_IF(!valid, fileName << " is not a KPI file written by this version");
+    std::vector<uint32_t> time(header.blockRows), imsi(header.blockRows), dl(header.blockRows), ul(header.blockRows);
+    std::vector<uint16_t> cell(header.blockRows);
+    std::cout << "timeMs,imsi,cellId,dlBytes,ulBytes\n";
+    uint32_t rows;
+    while (fread(&rows, sizeof(rows), 1, file) == 1 && rows <= header.blockRows) {
+        bool complete = fread(time.data(), sizeof(uint32_t), rows, file) == rows &&
+                        fread(imsi.data(), sizeof(uint32_t), rows, file) == rows &&
+                        fread(cell.data(), sizeof(uint16_t), rows, file) == rows &&
+                        fread(dl.data(), sizeof(uint32_t), rows, file) == rows &&
+                        fread(ul.data(), sizeof(uint32_t), rows, file) == rows;
+        if (!complete) {
+            break;  // truncated last block of an interrupted run
+        }
+        for (uint32_t i = 0; i < rows; ++i) {
+            std::cout << time[i] << "," << imsi[i] << "," << cell[i] << "," << dl[i] << "," << ul[i] << "\n";
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Memory-mapped fading trace
+//
+// TraceFadingLossModel parses the text .fad trace into a private heap copy in
+// every process. --convertFadingTrace stores exactly the samples it would
+// read (RbNum rows of SamplesNum values, zero-padded past the end of the
+// file, as the text loader does) as raw doubles, and
+// MappedTraceFadingLossModel maps that file read-only, so concurrent runs
+// share one page-cache copy. Window offsets and their random variables are
+// drawn the same way as in TraceFadingLossModel, so results are identical;
+// --fadingCheck runs the same scenario with both traces to confirm it.
+//
+// File layout: FadingFileHeader, then double sample[rbNum][samplesNum] (dB)
+// ---------------------------------------------------------------------------
+
+struct FadingFileHeader {
+    char magic[4];  // "FADB"
+    uint32_t version;
+    uint32_t rbNum;
+    uint32_t samplesNum;
+};
+
+// True if fileName starts with the binary fading trace magic
+bool IsMappedFadingTrace(const std::string &fileName) {
+    char magic[4] = {0};
+    std::ifstream in(fileName, std::ios::binary);
+    in.read(magic, sizeof(magic));
+    return in && std::memcmp(magic, "FADB", 4) == 0;
+}
+
+int ConvertFadingTrace(const std::string &textFile, const std::string &binaryFile, uint32_t rbNum, uint32_t samplesNum) {
+    std::ifstream in(textFile);
+    NS_ABORT_MSG_IF(!in, "Cannot open fading trace " << textFile);
+    FILE *out = fopen(binaryFile.c_str(), "wb");
+    NS_ABORT_MSG_IF(!out, "Cannot open " << binaryFile);
+    FadingFileHeader header = {{'F', 'A', 'D', 'B'}, 1, rbNum, samplesNum};
+    fwrite(&header, sizeof(header), 1, out);
+    std::vector<double> row(samplesNum);
+    uint64_t parsed = 0;
+    for (uint32_t rb = 0; rb < rbNum; ++rb) {
+        for (uint32_t j = 0; j < samplesNum; ++j) {
+            double sample = 0.0;  // a failed read leaves 0, like TraceFadingLossModel::LoadTrace
+            in >> sample;
+            parsed += in ? 1 : 0;
+            row[j] = sample;
+        }
+        fwrite(row.data(), sizeof(double), samplesNum, out);
+    }
+    bool ok = fclose(out) == 0;
+    NS_ABORT_MSG_IF(!ok, "Failed to write " << binaryFile);
+    std::cout << "Converted " << textFile << " -> " << binaryFile << ": " << rbNum << " RBs x " << samplesNum
+              << " samples (" << parsed << " read from the trace, the rest zero)" << std::endl;
+    return 0;
+}
+
+class MappedTraceFadingLossModel : public SpectrumPropagationLossModel {
+public:
+    MappedTraceFadingLossModel()
+        : m_mapping(nullptr), m_mappingSize(0), m_samples(nullptr), m_timeGranularity(0), m_currentStream(0),
+          m_lastStream(0), m_streamsAssigned(false) {
+    }
+
+    static TypeId GetTypeId() {
+        static TypeId tid =
+            TypeId("ns3::MappedTraceFadingLossModel")
+                .SetParent<SpectrumPropagationLossModel>()
+                .SetGroupName("Lte")
+                .AddConstructor<MappedTraceFadingLossModel>()
+                .AddAttribute("TraceFilename", "Binary fading trace written by --convertFadingTrace",
+                              StringValue(""),
+                              MakeStringAccessor(&MappedTraceFadingLossModel::m_traceFile),
+                              MakeStringChecker())
+                .AddAttribute("TraceLength", "The total length of the fading trace",
+                              TimeValue(Seconds(10)),
+                              MakeTimeAccessor(&MappedTraceFadingLossModel::m_traceLength),
+                              MakeTimeChecker())
+                .AddAttribute("SamplesNum", "The number of samples per RB the trace was converted with",
+                              UintegerValue(10000),
+                              MakeUintegerAccessor(&MappedTraceFadingLossModel::m_samplesNum),
+                              MakeUintegerChecker<uint32_t>())
+                .AddAttribute("WindowSize", "The size of the window for the fading trace",
+                              TimeValue(MilliSeconds(500)),
+                              MakeTimeAccessor(&MappedTraceFadingLossModel::m_windowSize),
+                              MakeTimeChecker())
+                .AddAttribute("RbNum", "The number of RBs the trace was converted with",
+                              UintegerValue(100),
+                              MakeUintegerAccessor(&MappedTraceFadingLossModel::m_rbNum),
+                              MakeUintegerChecker<uint8_t>())
+                .AddAttribute("RngStreamSetSize", "The number of RNG streams reserved for the fading model",
+                              UintegerValue(200000),
+                              MakeUintegerAccessor(&MappedTraceFadingLossModel::m_streamSetSize),
+                              MakeUintegerChecker<uint64_t>());
+        return tid;
+    }
+
+    // Read every sample once, so the whole trace is resident (used by the load benchmark)
+    double Touch() const {
+        Map();
+        return std::accumulate(m_samples, m_samples + uint64_t(m_rbNum) * m_samplesNum, 0.0);
+    }
+
+protected:
+    void DoInitialize() override {
+        Map();
+        SpectrumPropagationLossModel::DoInitialize();
+    }
+
+    void DoDispose() override {
+        if (m_mapping) {
+            munmap(m_mapping, m_mappingSize);
+            m_mapping = nullptr;
+            m_samples = nullptr;
+        }
+        m_windowOffsetsMap.clear();
+        m_startVariableMap.clear();
+        SpectrumPropagationLossModel::DoDispose();
+    }
+
+    Ptr<SpectrumValue> DoCalcRxPowerSpectralDensity(Ptr<const SpectrumSignalParameters> params,
+                                                    Ptr<const MobilityModel> a,
+                                                    Ptr<const MobilityModel> b) const override {
+        Map();
+        Ptr<SpectrumValue> rxPsd = Copy<SpectrumValue>(params->psd);
+        ChannelRealizationId key = std::make_pair(a, b);
+        auto offset = m_windowOffsetsMap.find(key);
+        if (offset != m_windowOffsetsMap.end()) {
+            if (Simulator::Now().GetMilliSeconds() - m_lastWindowUpdate.GetMilliSeconds() >
+                m_windowSize.GetMilliSeconds()) {
+                // New window: redraw the offset of every channel realization
+                auto variable = m_startVariableMap.begin();
+                for (auto &windowOffset : m_windowOffsetsMap) {
+                    windowOffset.second = variable->second->GetValue();
+                    ++variable;
+                }
+                m_lastWindowUpdate = Simulator::Now();
+            }
+        } else {
+            // Same attributes as TraceFadingLossModel::DoCalcRxPowerSpectralDensity in ns-3.41
+            Ptr<UniformRandomVariable> start = CreateObject<UniformRandomVariable>();
+            start->SetAttribute("Min", DoubleValue(1.0));
+            start->SetAttribute("Max", DoubleValue((m_traceLength.GetSeconds() - m_windowSize.GetSeconds()) * 1000.0));
+            if (m_streamsAssigned) {
+                NS_ABORT_MSG_IF(m_currentStream > m_lastStream, "Not enough fading RNG streams, increase RngStreamSetSize");
+                start->SetStream(m_currentStream++);
+            }
+            m_startVariableMap.emplace(key, start);
+            offset = m_windowOffsetsMap.emplace(key, start->GetValue()).first;
+        }
+
+        int nowMs = static_cast<int>(Simulator::Now().GetMilliSeconds() * m_timeGranularity);
+        int lastUpdateMs = static_cast<int>(m_lastWindowUpdate.GetMilliSeconds() * m_timeGranularity);
+        int index = (offset->second + nowMs - lastUpdateMs) % m_samplesNum;
+        uint32_t subChannel = 0;
+        for (auto value = rxPsd->ValuesBegin(); value != rxPsd->ValuesEnd(); ++value, ++subChannel) {
+            NS_ABORT_MSG_IF(subChannel >= m_rbNum, "Spectrum has more RBs than the fading trace");
+            if (*value != 0.) {
+                double fading = m_samples[uint64_t(subChannel) * m_samplesNum + index];
+                double power = 10 * std::log10(180000 * *value);  // W/Hz -> dB per RB
+                *value = std::pow(10., ((power + fading) / 10)) / 180000;
+            }
+        }
+        return rxPsd;
+    }
+
+    int64_t DoAssignStreams(int64_t stream) override {
+        m_currentStream = stream;
+        m_lastStream = stream + m_streamSetSize - 1;
+        m_streamsAssigned = true;
+        return m_streamSetSize;
+    }
+
+private:
+    typedef std::pair<Ptr<const MobilityModel>, Ptr<const MobilityModel>> ChannelRealizationId;
+
+    void Map() const {
+        if (m_samples) {
+            return;
+        }
+        int fd = open(m_traceFile.c_str(), O_RDONLY);
+        NS_ABORT_MSG_IF(fd < 0, "Cannot open fading trace " << m_traceFile);
+        struct stat info;
+        NS_ABORT_MSG_IF(fstat(fd, &info) != 0, "Cannot stat fading trace " << m_traceFile);
+        m_mappingSize = info.st_size;
+        m_mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        NS_ABORT_MSG_IF(m_mapping == MAP_FAILED, "Cannot map fading trace " << m_traceFile);
+        const FadingFileHeader *header = static_cast<const FadingFileHeader *>(m_mapping);
+        bool valid = m_mappingSize >= sizeof(FadingFileHeader) && std::memcmp(header->magic, "FADB", 4) == 0 &&
+                     m_mappingSize >= sizeof(FadingFileHeader) + sizeof(double) * uint64_t(header->rbNum) * header->samplesNum;
+        NS_ABORT_MSG_IF(!valid, m_traceFile << " is not a binary fading trace written by this version");
+        NS_ABORT_MSG_IF(header->rbNum != m_rbNum || header->samplesNum != m_samplesNum,
+                        m_traceFile << " was converted with RbNum=" << header->rbNum << " SamplesNum="
+                                    << header->samplesNum << ", reconvert it for the current settings");
+        m_samples = reinterpret_cast<const double *>(static_cast<const char *>(m_mapping) + sizeof(FadingFileHeader));
+        m_timeGranularity = static_cast<uint8_t>(m_traceLength.GetMilliSeconds() / m_samplesNum);
+        m_lastWindowUpdate = Simulator::Now();
+    }
+
+    std::string m_traceFile;
+    Time m_traceLength;
+    uint32_t m_samplesNum;
+    Time m_windowSize;
+    uint8_t m_rbNum;
+    uint64_t m_streamSetSize;
+
+    mutable void *m_mapping;
+    mutable size_t m_mappingSize;
+    mutable const double *m_samples;
+    mutable uint8_t m_timeGranularity;
+    mutable Time m_lastWindowUpdate;
+    mutable std::map<ChannelRealizationId, int> m_windowOffsetsMap;
+    mutable std::map<ChannelRealizationId, Ptr<UniformRandomVariable>> m_startVariableMap;
+    mutable uint64_t m_currentStream;
+    mutable uint64_t m_lastStream;
+    bool m_streamsAssigned;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(MappedTraceFadingLossModel);
+
+// Parameters of a single simulation run (one point of a sweep)
+struct SimulationConfig {
+    uint16_t numberOfUes = 41;
+    uint32_t siteTiers = 0;             // hexagonal rings around the centre site (0 = baseline 2-3-2 grid)
+    double interSiteDistance = 500.0;   // m
+    uint32_t sectorsPerSite = 3;        // 7 sites * 3 sectors each = 21 eNBs by default
+    uint16_t numberOfEnbs = 0;          // deprecated: first N cells of the baseline grid (0 = all)
+    uint32_t x2Neighbours = 0;          // X2 links per cell to its nearest cells (0 = full mesh up to one tier)
+    Time simTime = Seconds(50.0);
+    bool disableDl = false;
+    bool disableUl = false;
+    bool useA2A4   = false;  // default: use A3-RSRP; set true for A2-A4-RSRQ
+    bool enableFading = false;
+    std::string trafficMode = "tcp";    // "tcp": OnOff/PacketSink full buffer, "saturated": RLC SM bearers
+    double hysteresis = 2.0;            // A3-RSRP hysteresis in dB (e.g. 2 dB):contentReference[oaicite:4]{index=4}
+    uint16_t timeToTrigger = 480;       // A3-RSRP TTT in ms (e.g. 480 ms):contentReference[oaicite:5]{index=5}
+    uint8_t servingCellThreshold = 30;  // A2-A4-RSRQ serving cell threshold in dB (e.g. 30 dB):contentReference[oaicite:6]{index=6}
+    uint8_t neighbourCellOffset = 2;    // A2-A4-RSRQ neighbor cell offset in dB (e.g. 2 dB)
+    double txPower = 46.0;              // eNB transmit power in dBm (46 dBm ~ 40 W):contentReference[oaicite:7]{index=7}
+    double minSpeed = 20.0;   // km/h (minimum UE speed, paper considered 20 km/h as low end):contentReference[oaicite:8]{index=8}
+    double maxSpeed = 120.0;  // km/h (maximum UE speed)
+    std::string ueBoundary = "none";  // random velocity UEs at the layout edge: none, wrap or reflect
+    std::string mobilityTrace;        // binary waypoint trace replacing the random velocities; empty = off
+    std::string fadingTrace = "src/lte/model/fading-traces/fading_trace_EVA_60kmph.fad";
+    uint32_t fadingSamples = 100000;  // samples per RB read from the fading trace
+    uint32_t rngRun = 1;      // ns-3 RNG run number (independent replication index)
+    bool verbose = true;      // log connection/handover events (false: no logging at all)
+    std::string eventLog;     // binary event log file; empty = text on stdout
+    uint32_t eventBufferSize = 65536;  // event ring buffer capacity (records)
+    std::string kpiFile;      // per-UE / per-cell KPI time series; empty = off
+    Time kpiInterval = MilliSeconds(100);
+    bool flowMonitor = true;  // false: throughput from the UE sinks, no FlowMonitor probes
+    bool rlcThroughput = false;  // throughput from the UE DRB RLC PDUs (always with saturated traffic)
+    Time branchAt = Seconds(0);  // end of the shared warm-up when branching
+    bool handoverStats = false;  // ping-pong / failure / interruption analytics (on with handoverStatsFile)
+    std::string handoverStatsFile;  // per-cell handover statistics (CSV); empty = off
+    Time pingPongWindow = Seconds(1);
+    Time rlfWindow = Seconds(1);    // radio link failure after a handover counts as too early
+    bool screen = false;            // geometry-only handover screening instead of the full stack
+    Time screenStep = MilliSeconds(200);  // screening measurement period (UE L3 filter period)
+    std::string telemetry;          // telemetry file or "unix:<path>"; empty = off
+    double telemetryPeriod = 1.0;   // wall-clock seconds between telemetry blocks
+    bool queueStats = false;        // track the event queue depth (peakQueueDepth) without telemetry
+    Time attachRamp = Seconds(0);   // > 0: geometry-selected cells, UEs attached in batches over this window
+    uint32_t attachBatches = 10;
+};
+
+// KPIs reported at the end of a run
+struct SimulationResult {
+    double throughputMbps = 0.0;
+    double anoh = 0.0;
+    double optimizationRatio = 0.0;  // 0 when no handovers occurred
+    uint32_t handoverCount = 0;
+    double wallSeconds = 0.0;  // wall-clock time of the run
+    uint64_t events = 0;       // simulator events executed
+    double pingPongRate = 0.0;     // fraction of handovers that were ping-pongs
+    uint32_t tooEarly = 0;
+    uint32_t tooLate = 0;
+    uint32_t handoverFailures = 0;
+    double interruptionMs = 0.0;   // mean HandoverStart -> HandoverEndOk latency
+    uint64_t peakRssKb = 0;        // peak resident set size of the process running the simulation
+    double connectedSeconds = 0.0;      // sim time until every UE had connected (-1: some never did)
+    double connectedWallSeconds = 0.0;  // wall-clock time from the start of the run until then
+    uint64_t peakQueueDepth = 0;        // with queueStats or telemetry, 0 otherwise
+};
+
+// Register every run parameter with the command line parser (also used to apply sweep points)
+void AddConfigValues(CommandLine &cmd, SimulationConfig &config) {
+    cmd.AddValue("numberOfUes", "Number of UEs", config.numberOfUes);
+    cmd.AddValue("siteTiers", "Hexagonal site tiers around the centre site (0 = baseline 2-3-2 grid)", config.siteTiers);
+    cmd.AddValue("interSiteDistance", "Inter-site distance (m)", config.interSiteDistance);
+    cmd.AddValue("sectorsPerSite", "Sector cells per site", config.sectorsPerSite);
+    cmd.AddValue("numberOfEnbs", "Deprecated: number of eNodeBs (total sectors) of the baseline grid", config.numberOfEnbs);
+    cmd.AddValue("x2Neighbours", "X2 links per cell to its nearest cells (0 = full mesh, or 12 beyond one tier)",
+                 config.x2Neighbours);
+    cmd.AddValue("simTime", "Simulation duration (seconds)", config.simTime);
+    cmd.AddValue("disableDl", "Disable downlink data flows", config.disableDl);
+    cmd.AddValue("disableUl", "Disable uplink data flows", config.disableUl);
+    cmd.AddValue("useA2A4", "Use A2-A4-RSRQ handover (default: A3-RSRP)", config.useA2A4);
+    cmd.AddValue("enableFading", "Enable fading model (EVA/ETU trace)", config.enableFading);
+    cmd.AddValue("trafficMode", "Full-buffer traffic: tcp (OnOff apps) or saturated (RLC SM bearers)", config.trafficMode);
+    cmd.AddValue("hysteresis", "A3-RSRP hysteresis (dB)", config.hysteresis);
+    cmd.AddValue("timeToTrigger", "A3-RSRP Time-to-Trigger (ms)", config.timeToTrigger);
+    cmd.AddValue("servingCellThreshold", "A2-A4-RSRQ serving cell threshold (dB)", config.servingCellThreshold);
+    cmd.AddValue("neighbourCellOffset", "A2-A4-RSRQ neighbor cell offset (dB)", config.neighbourCellOffset);
+    cmd.AddValue("txPower", "eNB transmit power (dBm)", config.txPower);
+    cmd.AddValue("minSpeed", "Minimum UE speed (km/h)", config.minSpeed);
+    cmd.AddValue("maxSpeed", "Maximum UE speed (km/h)", config.maxSpeed);
+    cmd.AddValue("ueBoundary", "Random velocity UEs at the layout edge: none, wrap or reflect", config.ueBoundary);
+    cmd.AddValue("mobilityTrace", "Binary UE waypoint trace (from --convertMobilityTrace) instead of random velocities", config.mobilityTrace);
+    cmd.AddValue("fadingTrace", "Fading trace file path (text .fad, or binary from --convertFadingTrace)", config.fadingTrace);
+    cmd.AddValue("fadingSamples", "Fading trace samples per RB", config.fadingSamples);
+    cmd.AddValue("rngRun", "RNG run number (replication index)", config.rngRun);
+    cmd.AddValue("verbose", "Log connection and handover events", config.verbose);
+    cmd.AddValue("eventLog", "Write events to this binary log instead of stdout", config.eventLog);
+    cmd.AddValue("eventBufferSize", "Event log ring buffer capacity (records)", config.eventBufferSize);
+    cmd.AddValue("kpiFile", "Stream per-UE/per-cell KPI samples to this file", config.kpiFile);
+    cmd.AddValue("kpiInterval", "KPI sampling interval", config.kpiInterval);
+    cmd.AddValue("flowMonitor", "Measure throughput with FlowMonitor (false: from the UE sinks)", config.flowMonitor);
+    cmd.AddValue("rlcThroughput", "Measure throughput from the RLC PDUs received on the UE DRBs", config.rlcThroughput);
+    cmd.AddValue("branchAt", "End of the shared warm-up before forking the --branches", config.branchAt);
+    cmd.AddValue("handoverStats", "Collect ping-pong, failure and interruption statistics", config.handoverStats);
+    cmd.AddValue("handoverStatsFile", "Write per-cell handover statistics to this CSV file", config.handoverStatsFile);
+    cmd.AddValue("pingPongWindow", "Maximum time of stay for a return handover to count as ping-pong", config.pingPongWindow);
+    cmd.AddValue("rlfWindow", "Radio link failures this soon after a handover count as too early", config.rlfWindow);
+    cmd.AddValue("screen", "Geometry-only handover screening (no protocol stack, no throughput)", config.screen);
+    cmd.AddValue("screenStep", "Measurement period of the screening mode", config.screenStep);
+    cmd.AddValue("telemetry", "Write live simulator telemetry to this file or unix:<socket path>", config.telemetry);
+    cmd.AddValue("telemetryPeriod", "Wall-clock seconds between telemetry blocks", config.telemetryPeriod);
+    cmd.AddValue("queueStats", "Track the peak event queue depth", config.queueStats);
+    cmd.AddValue("attachRamp", "Attach UEs to geometry-selected cells in batches over this window (0: all at once with cell search)", config.attachRamp);
+    cmd.AddValue("attachBatches", "Number of attach batches within attachRamp", config.attachBatches);
+}
+
+// Value of a "<key>: <n> kB" line in a /proc file, 0 if absent
+uint64_t ReadProcKb(const std::string &fileName, const std::string &key) {
+    std::ifstream in(fileName);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, key.size() + 1, key + ":") == 0) {
+            return std::strtoull(line.c_str() + key.size() + 1, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Simulator telemetry
+//
+// With --telemetry the run installs TelemetrySimulatorImpl, a
+// DefaultSimulatorImpl that wraps every scheduled event so it can be counted
+// and timed against the type of its callback: the class owning the member
+// function (LteEnbPhy, TcpSocketBase, ...), or the free function / lambda type.
+// Every telemetryPeriod of wall-clock time, and at the end of every
+// Simulator::Run(), it writes one text block
+//   tick <wallS> <simS> <events in interval> <queue depth> <peak depth> <rssKb>
+//   type <events in interval> <wallMs in interval> <component>   (one per active component)
+// to a file, or to the unix socket of a --telemetryView ("unix:<path>"), and
+// "end" when the run is torn down. With only --queueStats it is installed
+// without a target and just counts the queue depth, without wrapping events.
+// Without either, the default simulator implementation runs untouched.
+// ---------------------------------------------------------------------------
+
+// Readable component of an event's dynamic type: the owning class for
+// MakeEvent(&Class::Method, obj, ...), otherwise the first template argument
+// of MakeEvent (the function pointer or lambda type)
+std::string EventComponentName(const std::type_info &type) {
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    std::string name = status == 0 ? demangled : type.name();
+    free(demangled);
+
+    size_t member = name.find("::*)");
+    size_t makeEvent = name.find("MakeEvent<");
+    if (member != std::string::npos) {
+        size_t begin = name.find_last_of("( ", member) + 1;
+        name = name.substr(begin, member - begin);
+    } else if (makeEvent != std::string::npos) {
+        size_t begin = makeEvent + std::strlen("MakeEvent<");
+        size_t end = begin;
+        int depth = 0;
+        for (; end < name.size(); ++end) {
+            char c = name[end];
+            depth += (c == '<' || c == '(') ? 1 : (c == '>' || c == ')') ? -1 : 0;
+            if (depth < 0 || (depth == 0 && c == ',')) {
+                break;
+            }
+        }
+        name = name.substr(begin, end - begin);
+    }
+    for (size_t pos = name.find("ns3::"); pos != std::string::npos; pos = name.find("ns3::")) {
+        name.erase(pos, 5);
+    }
+    return name;
+}
+
+class TelemetrySimulatorImpl : public DefaultSimulatorImpl {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::TelemetrySimulatorImpl")
+                                .SetParent<DefaultSimulatorImpl>()
+                                .SetGroupName("Core")
+                                .AddConstructor<TelemetrySimulatorImpl>();
+        return tid;
+    }
+
+    ~TelemetrySimulatorImpl() override {
+        Close();
+    }
+
+    // Send telemetry to `target` (a file, or "unix:<path>"); also used after a
+    // fork to give a branch its own target
+    void Open(const std::string &target, double period) {
+        if (m_fd >= 0) {
+            close(m_fd);  // a forked branch drops the warm-up target without ending it
+        }
+        m_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(period));
+        m_socket = target.compare(0, 5, "unix:") == 0;
+        if (m_socket) {
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            NS_ABORT_MSG_IF(target.size() - 5 >= sizeof(address.sun_path), "Socket path too long: " << target);
+            std::strcpy(address.sun_path, target.c_str() + 5);
+            m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            NS_ABORT_MSG_IF(m_fd < 0 || connect(m_fd, (sockaddr *)&address, sizeof(address)) != 0,
+                            "Cannot connect to telemetry viewer at " << target);
+        } else {
+            m_fd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            NS_ABORT_MSG_IF(m_fd < 0, "Cannot open telemetry file " << target);
+        }
+        m_start = std::chrono::steady_clock::now();
+        m_nextEmit = m_start + m_period;
+        m_lastEvents = GetEventCount();
+    }
+
+    // Final block and "end", then release the target
+    void Close() {
+        if (m_fd < 0) {
+            return;
+        }
+        Emit(std::chrono::steady_clock::now());
+        if (m_fd >= 0) {
+            WriteText("end\n");
+        }
+        if (m_fd >= 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    EventId Schedule(const Time &delay, EventImpl *event) override {
+        return DefaultSimulatorImpl::Schedule(delay, Wrap(event));
+    }
+
+    void ScheduleWithContext(uint32_t context, const Time &delay, EventImpl *event) override {
+        DefaultSimulatorImpl::ScheduleWithContext(context, delay, Wrap(event));
+    }
+
+    EventId ScheduleNow(EventImpl *event) override {
+        return DefaultSimulatorImpl::ScheduleNow(Wrap(event));
+    }
+
+    void Remove(const EventId &id) override {
+        if (id.GetUid() != EventId::UID::DESTROY && !IsExpired(id)) {
+            ++m_removed;
+        }
+        DefaultSimulatorImpl::Remove(id);
+    }
+
+    void Run() override {
+        DefaultSimulatorImpl::Run();
+        Emit(std::chrono::steady_clock::now());
+    }
+
+    // Events scheduled but not yet executed (cancelled ones included, as they
+    // stay in the queue until their time comes)
+    uint64_t GetQueueDepth() const {
+        return m_scheduled - m_removed - GetEventCount();
+    }
+
+    uint64_t GetPeakQueueDepth() const {
+        return m_peakDepth;
+    }
+
+private:
+    struct ComponentStats {
+        std::string name;
+        uint64_t executed = 0;
+        uint64_t nanoseconds = 0;
+    };
+
+    // Owns the scheduled event and runs it on behalf of the simulator
+    class TimedEvent : public EventImpl {
+    public:
+        TimedEvent(TelemetrySimulatorImpl *owner, EventImpl *event, ComponentStats *stats)
+            : m_owner(owner), m_event(event), m_stats(stats) {
+        }
+
+        ~TimedEvent() override {
+            m_event->Unref();
+        }
+
+    protected:
+        void Notify() override {
+            m_owner->Execute(m_event, m_stats);
+        }
+
+    private:
+        TelemetrySimulatorImpl *m_owner;
+        EventImpl *m_event;
+        ComponentStats *m_stats;
+    };
+
+    EventImpl *Wrap(EventImpl *event) {
+        const std::type_info *type = &typeid(*event);
+        if (*type == typeid(TimedEvent)) {
+            return event;  // already wrapped (ScheduleNow forwarding to Schedule)
+        }
+        ++m_scheduled;
+        m_peakDepth = std::max(m_peakDepth, GetQueueDepth());
+        if (m_fd < 0) {
+            return event;  // queue depth only
+        }
+        auto found = m_typeStats.find(type);
+        if (found == m_typeStats.end()) {
+            std::string name = EventComponentName(*type);
+            auto component = m_componentIndex.find(name);
+            if (component == m_componentIndex.end()) {
+                m_components.push_back(ComponentStats{name});
+                component = m_componentIndex.emplace(name, &m_components.back()).first;
+            }
+            found = m_typeStats.emplace(type, component->second).first;
+        }
+        return new TimedEvent(this, event, found->second);
+    }
+
+    void Execute(EventImpl *event, ComponentStats *stats) {
+        auto begin = std::chrono::steady_clock::now();
+        event->Invoke();
+        auto end = std::chrono::steady_clock::now();
+        ++stats->executed;
+        stats->nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        if (end >= m_nextEmit) {
+            Emit(end);
+        }
+    }
+
+    void Emit(std::chrono::steady_clock::time_point now) {
+        if (m_fd < 0) {
+            return;
+        }
+        std::ostringstream block;
+        uint64_t events = GetEventCount();
+        block << "tick " << std::chrono::duration<double>(now - m_start).count() << " " << Now().GetSeconds() << " "
+              << events - m_lastEvents << " " << GetQueueDepth() << " " << m_peakDepth << " "
+              << ReadProcKb("/proc/self/status", "VmRSS") << "\n";
+        m_lastEvents = events;
+        for (auto &component : m_components) {
+            if (component.executed > 0) {
+                block << "type " << component.executed << " " << component.nanoseconds / 1e6 << " "
+                      << component.name << "\n";
+                component.executed = 0;
+                component.nanoseconds = 0;
+            }
+        }
+        WriteText(block.str());
+        m_nextEmit = now + m_period;
+    }
+
+    // A viewer that went away ends the telemetry, not the run
+    void WriteText(const std::string &text) {
+        ssize_t written = m_socket ? send(m_fd, text.data(), text.size(), MSG_NOSIGNAL)
+                                   : write(m_fd, text.data(), text.size());
+        if (written != (ssize_t)text.size()) {
+            std::cerr << "Telemetry output failed, continuing without it" << std::endl;
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    int m_fd = -1;
+    bool m_socket = false;
+    std::chrono::steady_clock::duration m_period;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_nextEmit;
+    uint64_t m_lastEvents = 0;
+    uint64_t m_scheduled = 0;
+    uint64_t m_removed = 0;
+    uint64_t m_peakDepth = 0;
+    std::deque<ComponentStats> m_components;  // deque: stable addresses for the wrapped events
+    std::map<std::string, ComponentStats *> m_componentIndex;
+    std::unordered_map<const std::type_info *, ComponentStats *> m_typeStats;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(TelemetrySimulatorImpl);
+
+// Installed by BuildScenario with --telemetry or --queueStats, owned by the simulator
+static TelemetrySimulatorImpl *g_telemetry = nullptr;
+
+// Follow a telemetry file (or accept one run on a unix socket) and print a
+// summary of every block: progress, rates, queue depth, RSS and the components
+// that took the most wall time in the interval
+int RunTelemetryViewer(const std::string &target, uint32_t topComponents) {
+    int fd = -1;
+    if (target.compare(0, 5, "unix:") == 0) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        NS_ABORT_MSG_IF(target.size() - 5 >= sizeof(address.sun_path), "Socket path too long: " << target);
+        std::strcpy(address.sun_path, target.c_str() + 5);
+        unlink(address.sun_path);
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        NS_ABORT_MSG_IF(listener < 0 || bind(listener, (sockaddr *)&address, sizeof(address)) != 0 ||
+                            listen(listener, 1) != 0,
+                        "Cannot listen on " << target);
+        std::cout << "Waiting for a run with --telemetry=" << target << std::endl;
+        fd = accept(listener, nullptr, nullptr);
+        close(listener);
+        unlink(address.sun_path);
+        NS_ABORT_MSG_IF(fd < 0, "accept failed on " << target);
+    } else {
+        std::cout << "Waiting for " << target << std::endl;
+        while ((fd = open(target.c_str(), O_RDONLY)) < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+    }
+
+    bool terminal = isatty(STDOUT_FILENO);
+    double lastWall = 0.0;
+    double lastSim = 0.0;
+    std::vector<std::pair<double, std::string>> components;  // (ms, "name (events)")
+    std::string tick;
+    auto printBlock = [&]() {
+        if (tick.empty()) {
+            return;
+        }
+        double wall, sim;
+        uint64_t events, depth, peak, rssKb;
+        std::istringstream in(tick);
+        in >> wall >> sim >> events >> depth >> peak >> rssKb;
+        double interval = std::max(wall - lastWall, 1e-9);
+        double busyMs = 0.0;
+        for (auto const &component : components) {
+            busyMs += component.first;
+        }
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2) << "wall " << wall << " s  sim " << sim << " s  ("
+            << (sim - lastSim) / interval << " sim-s/s)  " << std::setprecision(0) << events / interval
+            << " events/s  queue " << depth << " (peak " << peak << ")  RSS " << rssKb / 1024 << " MB\n";
+        std::sort(components.rbegin(), components.rend());
+        for (size_t i = 0; i < components.size() && i < topComponents; ++i) {
+            out << std::setw(8) << std::setprecision(1) << 100.0 * components[i].first / std::max(busyMs, 1e-9)
+                << "%  " << components[i].second << "\n";
+        }
+        std::cout << (terminal ? "\033[H\033[J" : "\n") << out.str() << std::flush;
+        lastWall = wall;
+        lastSim = sim;
+        components.clear();
+        tick.clear();
+    };
+
+    std::string pending;
+    char buffer[65536];
+    while (true) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count < 0 || (count == 0 && target.compare(0, 5, "unix:") == 0)) {
+            break;  // run ended without "end"
+        }
+        if (count == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            continue;
+        }
+        pending.append(buffer, count);
+        size_t lineEnd;
+        while ((lineEnd = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, lineEnd);
+            pending.erase(0, lineEnd + 1);
+            if (line.compare(0, 5, "tick ") == 0) {
+                printBlock();
+                tick = line.substr(5);
+            } else if (line.compare(0, 5, "type ") == 0) {
+                std::istringstream in(line.substr(5));
+                uint64_t events;
+                double ms;
+                std::string name;
+                in >> events >> ms;
+                std::getline(in >> std::ws, name);
+                components.emplace_back(ms, name + " (" + std::to_string(events) + " events)");
+            } else if (line == "end") {
+                printBlock();
+                close(fd);
+                std::cout << "Run finished" << std::endl;
+                return 0;
+            }
+        }
+    }
+    printBlock();
+    close(fd);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Site layout
+//
+// By default (siteTiers = 0) the cells use the original 2-3-2 grid of 7 sites
+// on a 1000 x 1000 m area. Otherwise sites sit on a hexagonal grid: tier 0 is
+// the centre site and tier t adds the 6t sites of the next ring (1 tier = 7
+// sites, 3 = 37, 10 = 331). Each site carries `sectorsPerSite` co-located
+// cells with evenly spaced antenna orientations. The layout is shifted so its
+// bounding box starts at (0, 0).
+// ---------------------------------------------------------------------------
+
+struct CellLayout {
+    std::vector<Vector> positions;     // eNB (site) position of every cell
+    std::vector<double> orientations;  // antenna orientation of every cell (degrees)
+    std::vector<Vector> centroids;     // point a third of the ISD down the boresight, used for X2 neighbours
+    double width = 0.0;                // bounding box of the sites (UE drop area)
+    double height = 0.0;
+};
+
+// X2 links per cell used when x2Neighbours is left at 0 on layouts larger
+// than one tier: the co-sited sectors plus the first ring around each cell
+static const uint32_t kDefaultX2Neighbours = 12;
+
+CellLayout ExpandSites(const std::vector<Vector> &sitePositions, double interSiteDistance, uint32_t sectorsPerSite) {
+    double minX = 0.0, minY = 0.0, maxX = 0.0, maxY = 0.0;
+    for (auto const &p : sitePositions) {
+        minX = std::min(minX, p.x);
+        minY = std::min(minY, p.y);
+        maxX = std::max(maxX, p.x);
+        maxY = std::max(maxY, p.y);
+    }
+
+    CellLayout layout;
+    layout.width = maxX - minX;
+    layout.height = maxY - minY;
+    for (auto const &p : sitePositions) {
+        Vector site(p.x - minX, p.y - minY, 0.0);
+        for (uint32_t s = 0; s < sectorsPerSite; ++s) {
+            double orientation = s * 360.0 / sectorsPerSite;
+            double offset = sectorsPerSite > 1 ? interSiteDistance / 3.0 : 0.0;
+            layout.positions.push_back(site);
+            layout.orientations.push_back(orientation);
+            layout.centroids.push_back(Vector(site.x + offset * std::cos(orientation * M_PI / 180.0),
+                                              site.y + offset * std::sin(orientation * M_PI / 180.0), 0.0));
+        }
+    }
+    return layout;
+}
+
+// The original 2-3-2 grid; with the default 500 m spacing and 3 sectors this
+// is exactly the 21-cell deployment the simulation started from
+CellLayout GenerateBaselineLayout(double interSiteDistance, uint32_t sectorsPerSite) {
+    static const double sites[7][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}, {2, 1}, {1, 2}, {2, 2}};
+    std::vector<Vector> sitePositions;
+    for (auto const &site : sites) {
+        sitePositions.push_back(Vector(interSiteDistance * site[0], interSiteDistance * site[1], 0.0));
+    }
+    return ExpandSites(sitePositions, interSiteDistance, sectorsPerSite);
+}
+
+CellLayout GenerateHexLayout(uint32_t tiers, double interSiteDistance, uint32_t sectorsPerSite) {
+    // Axial hex directions, walked in order around each ring
+    static const int directions[6][2] = {{1, 0}, {1, -1}, {0, -1}, {-1, 0}, {-1, 1}, {0, 1}};
+    std::vector<std::pair<int, int>> sites = {{0, 0}};
+    for (int ring = 1; ring <= static_cast<int>(tiers); ++ring) {
+        int q = directions[4][0] * ring;
+        int r = directions[4][1] * ring;
+        for (int side = 0; side < 6; ++side) {
+            for (int step = 0; step < ring; ++step) {
+                sites.emplace_back(q, r);
+                q += directions[side][0];
+                r += directions[side][1];
+            }
+        }
+    }
+
+    std::vector<Vector> sitePositions;
+    for (auto const &site : sites) {
+        sitePositions.push_back(Vector(interSiteDistance * (site.first + site.second / 2.0),
+                                       interSiteDistance * site.second * std::sqrt(3.0) / 2.0, 0.0));
+    }
+    return ExpandSites(sitePositions, interSiteDistance, sectorsPerSite);
+}
+
+CellLayout BuildLayout(const SimulationConfig &config) {
+    if (config.siteTiers == 0) {
+        CellLayout layout = GenerateBaselineLayout(config.interSiteDistance, config.sectorsPerSite);
+        if (config.numberOfEnbs > 0) {
+            // Deprecated: like the original ListPositionAllocator, keep only the first cells of the grid
+            NS_ABORT_MSG_IF(config.numberOfEnbs > layout.positions.size(),
+                            "numberOfEnbs is larger than the " << layout.positions.size() << " cells of the grid");
+            layout.positions.resize(config.numberOfEnbs);
+            layout.orientations.resize(config.numberOfEnbs);
+            layout.centroids.resize(config.numberOfEnbs);
+        }
+        return layout;
+    }
+    NS_ABORT_MSG_IF(config.numberOfEnbs > 0, "numberOfEnbs only applies to the baseline grid (siteTiers=0)");
+    return GenerateHexLayout(config.siteTiers, config.interSiteDistance, config.sectorsPerSite);
+}
+
+// X2 links per cell, or 0 for the full mesh
+uint32_t X2NeighbourCount(const SimulationConfig &config) {
+    if (config.x2Neighbours > 0) {
+        return config.x2Neighbours;
+    }
+    return config.siteTiers > 1 ? kDefaultX2Neighbours : 0;
+}
+
+// K nearest neighbours of every point, using a uniform bucket grid so each
+// query only visits the buckets around the point (O(N K log K) overall)
+std::vector<std::vector<uint32_t>> FindNearestNeighbours(const std::vector<Vector> &points, uint32_t k, double bucketSize) {
+    std::vector<std::vector<uint32_t>> neighbours(points.size());
+    if (points.empty() || k == 0) {
+        return neighbours;
+    }
+    double minX = points[0].x, minY = points[0].y, maxX = points[0].x, maxY = points[0].y;
+    for (auto const &p : points) {
+        minX = std::min(minX, p.x);
+        minY = std::min(minY, p.y);
+        maxX = std::max(maxX, p.x);
+        maxY = std::max(maxY, p.y);
+    }
+    int columns = static_cast<int>((maxX - minX) / bucketSize) + 1;
+    int rows = static_cast<int>((maxY - minY) / bucketSize) + 1;
+    std::vector<std::vector<uint32_t>> buckets(columns * rows);
+    auto column = [&](const Vector &p) { return static_cast<int>((p.x - minX) / bucketSize); };
+    auto row = [&](const Vector &p) { return static_cast<int>((p.y - minY) / bucketSize); };
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        buckets[row(points[i]) * columns + column(points[i])].push_back(i);
+    }
+
+    k = std::min<uint32_t>(k, points.size() - 1);
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        // Max-heap of (squared distance, index) holding the best k so far
+        std::priority_queue<std::pair<double, uint32_t>> best;
+        int c0 = column(points[i]);
+        int r0 = row(points[i]);
+        for (int ring = 0; ring <= std::max(columns, rows); ++ring) {
+            for (int r = r0 - ring; r <= r0 + ring; ++r) {
+                for (int c = c0 - ring; c <= c0 + ring; ++c) {
+                    // Only the buckets on the border of the current ring
+                    bool border = std::abs(r - r0) == ring || std::abs(c - c0) == ring;
+                    if (!border || r < 0 || r >= rows || c < 0 || c >= columns) {
+                        continue;
+                    }
+                    for (uint32_t j : buckets[r * columns + c]) {
+                        if (j == i) {
+                            continue;
+                        }
+                        double dx = points[j].x - points[i].x;
+                        double dy = points[j].y - points[i].y;
+                        best.emplace(dx * dx + dy * dy, j);
+                        if (best.size() > k) {
+                            best.pop();
+                        }
+                    }
+                }
+            }
+            // Anything in the next ring is at least ring * bucketSize away
+            double reach = ring * bucketSize;
+            if (best.size() == k && best.top().first <= reach * reach) {
+                break;
+            }
+        }
+        while (!best.empty()) {
+            neighbours[i].push_back(best.top().second);
+            best.pop();
+        }
+    }
+    return neighbours;
+}
+
+// Cell pairs linked by X2 when each cell only connects to its k nearest cells
+std::set<std::pair<uint32_t, uint32_t>> FindX2Links(const std::vector<Vector> &centroids, uint32_t k, double bucketSize) {
+    std::vector<std::vector<uint32_t>> neighbours = FindNearestNeighbours(centroids, k, bucketSize);
+    std::set<std::pair<uint32_t, uint32_t>> links;
+    for (uint32_t i = 0; i < neighbours.size(); ++i) {
+        for (uint32_t j : neighbours[i]) {
+            links.emplace(std::min(i, j), std::max(i, j));
+        }
+    }
+    return links;
+}
+
+// Random UE drop inside the site bounding box with constant random velocities.
+// The stream is pinned, so the drop and headings depend on rngRun only, not on
+// how many random variables the rest of the configuration created first
+// (common random numbers); the screening mode draws the very same UEs.
+//
+// RandomVariableStream::SetStream(s), which AssignStreams() also calls, selects
+// the RNG substream 2^63 + s, while automatic streams use 0 .. 2^63 - 1, so the
+// two can never collide. Within the explicit range, AssignStreams() counts up
+// from the number it is given (the fading model alone reserves 200000 per
+// instance); 2^62 stays clear of any such range that starts below 2^62.
+static const int64_t kUeDropStream = int64_t(1) << 62;
+
+struct UeDrop {
+    std::vector<Vector> positions;
+    std::vector<Vector> velocities;  // m/s
+};
+
+UeDrop DrawUeDrop(const SimulationConfig &config, const CellLayout &layout) {
+    UeDrop drop;
+    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
+    rand->SetStream(kUeDropStream);
+    for (uint32_t u = 0; u < config.numberOfUes; ++u) {
+        double x = rand->GetValue(0.0, layout.width);
+        double y = rand->GetValue(0.0, layout.height);
+        drop.positions.push_back(Vector(x, y, 0.0));
+        // Random speed (km/h converted to m/s) and direction
+        double speedKmph = rand->GetValue(config.minSpeed, config.maxSpeed);
+        double speedMps  = speedKmph * 1000.0 / 3600.0;
+        double theta = rand->GetValue(0.0, 2 * M_PI);
+        drop.velocities.push_back(Vector(speedMps * std::cos(theta), speedMps * std::sin(theta), 0.0));
+    }
+    return drop;
+}
+
+// ---------------------------------------------------------------------------
+// UE mobility
+//
+// Without a trace, UEs keep the constant velocities of DrawUeDrop. With
+// ueBoundary=wrap or reflect they stay inside the site bounding box:
+// BoundedVelocityMobilityModel folds the straight-line track back into the
+// box whenever the position is queried (wrap: leave on one edge and re-enter
+// on the opposite one; reflect: bounce off the edge), so no course-change
+// events are scheduled.
+//
+// --mobilityTrace replays a binary waypoint trace written by
+// --convertMobilityTrace. The file is mapped read-only, and each UE only keeps
+// a cursor to its current waypoint, advanced when its position is queried.
+// Memory therefore does not grow with the trace length, and concurrent runs
+// share one page-cache copy. Positions are linearly interpolated between
+// waypoints, in the layout frame (bounding box from (0, 0)); a UE stays at its
+// first waypoint until that time and at its last one afterwards.
+//
+// File layout: MobilityTraceHeader, MobilityTraceUe[numUes], then the
+// MobilityWaypoint[numWaypoints] of UE 0, UE 1, ..., each sorted by time
+// ---------------------------------------------------------------------------
+
+enum UeBoundary : uint8_t {
+    BOUNDARY_NONE,
+    BOUNDARY_WRAP,
+    BOUNDARY_REFLECT
+};
+
+UeBoundary ParseUeBoundary(const std::string &mode) {
+    NS_ABORT_MSG_IF(mode != "none" && mode != "wrap" && mode != "reflect", "Unknown ueBoundary " << mode);
+    return mode == "wrap" ? BOUNDARY_WRAP : mode == "reflect" ? BOUNDARY_REFLECT : BOUNDARY_NONE;
+}
+
+// Fold one coordinate of a straight-line track into [0, size]. `direction`
+// is -1 while a reflected UE travels back along that axis.
+double FoldCoordinate(double value, double size, UeBoundary boundary, double &direction) {
+    direction = 1.0;
+    if (boundary == BOUNDARY_NONE || size <= 0.0) {
+        return value;
+    }
+    double period = boundary == BOUNDARY_WRAP ? size : 2 * size;
+    double folded = std::fmod(value, period);
+    folded += folded < 0.0 ? period : 0.0;
+    if (folded > size) {
+        direction = -1.0;
+        return period - folded;
+    }
+    return folded;
+}
+
+// Position after `t` seconds of a UE starting at `start` with constant
+// `velocity` in a width x height box; also its current velocity if requested
+Vector BoundedPosition(const Vector &start, const Vector &velocity, double t, double width, double height,
+                       UeBoundary boundary, Vector *currentVelocity = nullptr) {
+    double dx, dy;
+    Vector position(FoldCoordinate(start.x + velocity.x * t, width, boundary, dx),
+                    FoldCoordinate(start.y + velocity.y * t, height, boundary, dy), start.z);
+    if (currentVelocity) {
+        *currentVelocity = Vector(velocity.x * dx, velocity.y * dy, velocity.z);
+    }
+    return position;
+}
+
+class BoundedVelocityMobilityModel : public MobilityModel {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::BoundedVelocityMobilityModel")
+                                .SetParent<MobilityModel>()
+                                .SetGroupName("Mobility")
+                                .AddConstructor<BoundedVelocityMobilityModel>();
+        return tid;
+    }
+
+    // Keep moving from the current position with `velocity` inside the box
+    void SetVelocity(const Vector &velocity, double width, double height, UeBoundary boundary) {
+        m_start = DoGetPosition();
+        m_startTime = Simulator::Now();
+        m_velocity = velocity;
+        m_width = width;
+        m_height = height;
+        m_boundary = boundary;
+        NotifyCourseChange();
+    }
+
+private:
+    Vector DoGetPosition() const override {
+        return BoundedPosition(m_start, m_velocity, (Simulator::Now() - m_startTime).GetSeconds(), m_width,
+                               m_height, m_boundary);
+    }
+
+    void DoSetPosition(const Vector &position) override {
+        m_start = position;
+        m_startTime = Simulator::Now();
+        NotifyCourseChange();
+    }
+
+    Vector DoGetVelocity() const override {
+        Vector velocity;
+        BoundedPosition(m_start, m_velocity, (Simulator::Now() - m_startTime).GetSeconds(), m_width, m_height,
+                        m_boundary, &velocity);
+        return velocity;
+    }
+
+    Vector m_start;
+    Time m_startTime;
+    Vector m_velocity;
+    double m_width = 0.0;
+    double m_height = 0.0;
+    UeBoundary m_boundary = BOUNDARY_NONE;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(BoundedVelocityMobilityModel);
+
+struct MobilityTraceHeader {
+    char magic[4];  // "MOBT"
+    uint32_t version;
+    uint32_t numUes;
+    uint32_t reserved;
+    uint64_t numWaypoints;
+};
+
+struct MobilityTraceUe {
+    uint64_t first;  // index of the UE's first waypoint
+    uint64_t count;
+};
+
+struct MobilityWaypoint {
+    double t;  // s
+    double x;  // m
+    double y;
+};
+
+// Read-only mapping of a binary mobility trace, shared by the UEs of a run
+class MobilityTrace {
+public:
+    explicit MobilityTrace(const std::string &fileName) {
+        int fd = open(fileName.c_str(), O_RDONLY);
+        NS_ABORT_MSG_IF(fd < 0, "Cannot open mobility trace " << fileName);
+        struct stat info;
+        NS_ABORT_MSG_IF(fstat(fd, &info) != 0, "Cannot stat mobility trace " << fileName);
+        m_mappingSize = info.st_size;
+        m_mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        NS_ABORT_MSG_IF(m_mapping == MAP_FAILED, "Cannot map mobility trace " << fileName);
+        const MobilityTraceHeader *header = static_cast<const MobilityTraceHeader *>(m_mapping);
+        bool valid = m_mappingSize >= sizeof(MobilityTraceHeader) && std::memcmp(header->magic, "MOBT", 4) == 0 &&
+                     header->version == 1 &&
+                     m_mappingSize == sizeof(MobilityTraceHeader) + sizeof(MobilityTraceUe) * uint64_t(header->numUes) +
+                                          sizeof(MobilityWaypoint) * header->numWaypoints;
+        NS_ABORT_MSG_IF(!valid, fileName << " is not a mobility trace written by --convertMobilityTrace");
+        m_numUes = header->numUes;
+        m_ues = reinterpret_cast<const MobilityTraceUe *>(header + 1);
+        m_waypoints = reinterpret_cast<const MobilityWaypoint *>(m_ues + m_numUes);
+    }
+
+    ~MobilityTrace() {
+        munmap(m_mapping, m_mappingSize);
+    }
+
+    MobilityTrace(const MobilityTrace &) = delete;
+    MobilityTrace &operator=(const MobilityTrace &) = delete;
+
+    uint32_t GetNUes() const {
+        return m_numUes;
+    }
+
+    // Position of `ue` at time t (s). `cursor` is the UE's current waypoint;
+    // it moves forward with t, so a query costs O(1) amortised.
+    Vector GetPosition(uint32_t ue, double t, uint64_t &cursor, Vector *velocity = nullptr) const {
+        const MobilityTraceUe &track = m_ues[ue];
+        const MobilityWaypoint *waypoints = m_waypoints + track.first;
+        if (cursor >= track.count || waypoints[cursor].t > t) {
+            cursor = 0;  // time went backwards
+        }
+        while (cursor + 1 < track.count && waypoints[cursor + 1].t <= t) {
+            ++cursor;
+        }
+        const MobilityWaypoint &from = waypoints[cursor];
+        if (cursor + 1 == track.count || t < from.t) {
+            if (velocity) {
+                *velocity = Vector(0.0, 0.0, 0.0);
+            }
+            return Vector(from.x, from.y, 0.0);
+        }
+        const MobilityWaypoint &to = waypoints[cursor + 1];
+        double vx = (to.x - from.x) / (to.t - from.t);
+        double vy = (to.y - from.y) / (to.t - from.t);
+        if (velocity) {
+            *velocity = Vector(vx, vy, 0.0);
+        }
+        return Vector(from.x + vx * (t - from.t), from.y + vy * (t - from.t), 0.0);
+    }
+
+private:
+    void *m_mapping;
+    size_t m_mappingSize;
+    uint32_t m_numUes;
+    const MobilityTraceUe *m_ues;
+    const MobilityWaypoint *m_waypoints;
+};
+
+class TraceMobilityModel : public MobilityModel {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::TraceMobilityModel")
+                                .SetParent<MobilityModel>()
+                                .SetGroupName("Mobility")
+                                .AddConstructor<TraceMobilityModel>();
+        return tid;
+    }
+
+    void SetTrace(std::shared_ptr<const MobilityTrace> trace, uint32_t ue) {
+        NS_ABORT_MSG_IF(ue >= trace->GetNUes(), "Mobility trace has no UE " << ue);
+        m_trace = trace;
+        m_ue = ue;
+        m_cursor = 0;
+        NotifyCourseChange();
+    }
+
+private:
+    Vector DoGetPosition() const override {
+        return m_trace ? m_trace->GetPosition(m_ue, Simulator::Now().GetSeconds(), m_cursor) : Vector();
+    }
+
+    // The trace owns the position; the helper's initial placement is ignored
+    void DoSetPosition(const Vector &position) override {
+    }
+
+    Vector DoGetVelocity() const override {
+        Vector velocity;
+        if (m_trace) {
+            m_trace->GetPosition(m_ue, Simulator::Now().GetSeconds(), m_cursor, &velocity);
+        }
+        return velocity;
+    }
+
+    std::shared_ptr<const MobilityTrace> m_trace;
+    uint32_t m_ue = 0;
+    mutable uint64_t m_cursor = 0;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(TraceMobilityModel);
+
+// Convert a text trace with one "ue time x y" waypoint per line ('#' starts a
+// comment) into the binary format. UEs are numbered from 0 and every UE up to
+// the highest number needs at least one waypoint.
+int ConvertMobilityTrace(const std::string &textFile, const std::string &binaryFile) {
+    std::ifstream in(textFile);
+    NS_ABORT_MSG_IF(!in, "Cannot open mobility trace " << textFile);
+    std::vector<std::pair<uint32_t, MobilityWaypoint>> waypoints;
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(line);
+        uint32_t ue;
+        MobilityWaypoint waypoint;
+        fields >> ue >> waypoint.t >> waypoint.x >> waypoint.y;
+        NS_ABORT_MSG_IF(!fields, textFile << ":" << lineNumber << ": expected \"ue time x y\"");
+        waypoints.emplace_back(ue, waypoint);
+    }
+    NS_ABORT_MSG_IF(waypoints.empty(), "No waypoints in " << textFile);
+    std::stable_sort(waypoints.begin(), waypoints.end(), [](auto const &a, auto const &b) {
+        return a.first != b.first ? a.first < b.first : a.second.t < b.second.t;
+    });
+
+    uint32_t numUes = waypoints.back().first + 1;
+    std::vector<MobilityTraceUe> ues(numUes, MobilityTraceUe{0, 0});
+    for (uint64_t i = 0; i < waypoints.size(); ++i) {
+        MobilityTraceUe &track = ues[waypoints[i].first];
+        track.first = track.count == 0 ? i : track.first;
+        ++track.count;
+    }
+    for (uint32_t ue = 0; ue < numUes; ++ue) {
+        NS_ABORT_MSG_IF(ues[ue].count == 0, "UE " << ue << " has no waypoints in " << textFile);
+    }
+
+    FILE *out = fopen(binaryFile.c_str(), "wb");
+    NS_ABORT_MSG_IF(!out, "Cannot open " << binaryFile);
+    MobilityTraceHeader header = {{'M', 'O', 'B', 'T'}, 1, numUes, 0, waypoints.size()};
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(ues.data(), sizeof(MobilityTraceUe), numUes, out);
+    for (auto const &waypoint : waypoints) {
+        fwrite(&waypoint.second, sizeof(MobilityWaypoint), 1, out);
+    }
+    bool ok = fclose(out) == 0;
+    NS_ABORT_MSG_IF(!ok, "Failed to write " << binaryFile);
+    std::cout << "Converted " << textFile << " -> " << binaryFile << ": " << numUes << " UEs, "
+              << waypoints.size() << " waypoints" << std::endl;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Warm-start branching
+//
+// The warm-up runs once with the base handover parameters. The simulator is
+// then fork()ed into one copy-on-write child per branch, and each child
+// finishes the run with its own handover parameters. A3 hysteresis/TTT live
+// in the UE measurement configuration, which cannot be changed once the UEs
+// are connected. So BranchedHandoverAlgorithm creates a stock
+// A3RsrpHandoverAlgorithm / A2A4RsrqHandoverAlgorithm for every distinct
+// variant up front, routes each measurement report to the algorithm that
+// configured it, and only lets the active variant's algorithm trigger
+// handovers. --validateBranches checks that, next to an A3 and an A2-A4
+// variant that differ from the base, the branch with the base parameters
+// reproduces a standalone run exactly. The extra reports travel over the
+// ideal RRC (UseIdealRrc) and use no radio resources; with the real RRC
+// they would take uplink grants and the branch would only be close.
+// ---------------------------------------------------------------------------
+
+struct HandoverVariant {
+    bool useA2A4;
+    double hysteresis;
+    uint16_t timeToTrigger;
+    uint8_t servingCellThreshold;
+    uint8_t neighbourCellOffset;
+};
+
+static std::vector<HandoverVariant> g_handoverVariants;  // [0] = base (warm-up) parameters
+static uint32_t g_activeHandoverVariant = 0;
+
+// Parameters that matter to the variant's algorithm; variants with the same key share one
+typedef std::tuple<bool, double, uint16_t, uint8_t, uint8_t> HandoverVariantKey;
+
+HandoverVariantKey GetHandoverVariantKey(const HandoverVariant &variant) {
+    if (variant.useA2A4) {
+        return HandoverVariantKey(true, 0.0, 0, variant.servingCellThreshold, variant.neighbourCellOffset);
+    }
+    return HandoverVariantKey(false, variant.hysteresis, variant.timeToTrigger, 0, 0);
+}
+
+class BranchedHandoverAlgorithm : public LteHandoverAlgorithm {
+public:
+    BranchedHandoverAlgorithm()
+        : m_handoverManagementSapUser(nullptr) {
+        m_handoverManagementSapProvider = new MemberLteHandoverManagementSapProvider<BranchedHandoverAlgorithm>(this);
+    }
+
+    ~BranchedHandoverAlgorithm() override {
+    }
+
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::BranchedHandoverAlgorithm")
+                                .SetParent<LteHandoverAlgorithm>()
+                                .SetGroupName("Lte")
+                                .AddConstructor<BranchedHandoverAlgorithm>();
+        return tid;
+    }
+
+    void SetLteHandoverManagementSapUser(LteHandoverManagementSapUser *s) override {
+        m_handoverManagementSapUser = s;
+    }
+
+    LteHandoverManagementSapProvider *GetLteHandoverManagementSapProvider() override {
+        return m_handoverManagementSapProvider;
+    }
+
+    friend class MemberLteHandoverManagementSapProvider<BranchedHandoverAlgorithm>;
+
+protected:
+    void DoInitialize() override {
+        // The stock algorithms add their report configurations while they initialise,
+        // which happens with the eNB device, before any UE connects
+        std::map<HandoverVariantKey, uint32_t> instances;
+        for (auto const &variant : g_handoverVariants) {
+            HandoverVariantKey key = GetHandoverVariantKey(variant);
+            if (instances.count(key) == 0) {
+                ObjectFactory factory;
+                if (variant.useA2A4) {
+                    factory.SetTypeId("ns3::A2A4RsrqHandoverAlgorithm");
+                    factory.Set("ServingCellThreshold", UintegerValue(variant.servingCellThreshold));
+                    factory.Set("NeighbourCellOffset", UintegerValue(variant.neighbourCellOffset));
+                } else {
+                    factory.SetTypeId("ns3::A3RsrpHandoverAlgorithm");
+                    factory.Set("Hysteresis", DoubleValue(variant.hysteresis));
+                    factory.Set("TimeToTrigger", TimeValue(MilliSeconds(variant.timeToTrigger)));
+                }
+                uint32_t index = m_algorithms.size();
+                instances[key] = index;
+                m_algorithms.push_back(factory.Create<LteHandoverAlgorithm>());
+                m_sapUsers.emplace_back(new GatedSapUser(this, index));
+                m_algorithms.back()->SetLteHandoverManagementSapUser(m_sapUsers.back().get());
+                m_algorithms.back()->Initialize();
+            }
+            m_variantAlgorithm.push_back(instances[key]);
+        }
+        LteHandoverAlgorithm::DoInitialize();
+    }
+
+    void DoDispose() override {
+        for (auto &algorithm : m_algorithms) {
+            algorithm->Dispose();
+        }
+        m_algorithms.clear();
+        m_sapUsers.clear();
+        delete m_handoverManagementSapProvider;
+        LteHandoverAlgorithm::DoDispose();
+    }
+
+    void DoReportUeMeas(uint16_t rnti, LteRrcSap::MeasResults measResults) override {
+        // Every algorithm keeps following its own reports (e.g. the A2-A4 neighbour
+        // table), whichever variant is active
+        auto owner = m_measIdOwner.find(measResults.measId);
+        if (owner != m_measIdOwner.end()) {
+            m_algorithms[owner->second]->GetLteHandoverManagementSapProvider()->ReportUeMeas(rnti, measResults);
+        }
+    }
+
+private:
+    // SAP user handed to one stock algorithm: report configurations go straight to
+    // the eNB RRC, handover commands only while the algorithm's variant is active
+    class GatedSapUser : public LteHandoverManagementSapUser {
+    public:
+        GatedSapUser(BranchedHandoverAlgorithm *owner, uint32_t algorithm)
+            : m_owner(owner),
+              m_algorithm(algorithm) {
+        }
+
+        std::vector<uint8_t> AddUeMeasReportConfigForHandover(LteRrcSap::ReportConfigEutra reportConfig) override {
+            std::vector<uint8_t> measIds =
+                m_owner->m_handoverManagementSapUser->AddUeMeasReportConfigForHandover(reportConfig);
+            for (uint8_t measId : measIds) {
+                m_owner->m_measIdOwner[measId] = m_algorithm;
+            }
+            return measIds;
+        }
+
+        void TriggerHandover(uint16_t rnti, uint16_t targetCellId) override {
+            if (m_owner->m_variantAlgorithm[g_activeHandoverVariant] == m_algorithm) {
+                m_owner->m_handoverManagementSapUser->TriggerHandover(rnti, targetCellId);
+            }
+        }
+
+    private:
+        BranchedHandoverAlgorithm *m_owner;
+        uint32_t m_algorithm;
+    };
+
+    std::vector<Ptr<LteHandoverAlgorithm>> m_algorithms;      // one stock algorithm per distinct variant
+    std::vector<std::unique_ptr<GatedSapUser>> m_sapUsers;    // SAP user of each algorithm
+    std::vector<uint32_t> m_variantAlgorithm;                 // variant -> algorithm
+    std::map<uint8_t, uint32_t> m_measIdOwner;                // measId -> algorithm that configured it
+    LteHandoverManagementSapUser *m_handoverManagementSapUser;
+    LteHandoverManagementSapProvider *m_handoverManagementSapProvider;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(BranchedHandoverAlgorithm);
+
+HandoverVariant MakeHandoverVariant(const SimulationConfig &config) {
+    return HandoverVariant{config.useA2A4, config.hysteresis, config.timeToTrigger,
+                           config.servingCellThreshold, config.neighbourCellOffset};
+}
+
+// ---------------------------------------------------------------------------
+// Geometry-only handover screening
+//
+// --screen replaces the protocol stack with the radio geometry of the same
+// scenario: the same layout, the same cosine antennas (65 degrees, 0 dB max
+// gain), the same UE drop and velocities, and Friis path loss at the DL
+// EARFCN 100 carrier. Every measurement period it computes RSRP and RSRQ for
+// all UE/cell pairs and applies the UE L3 filter. It then runs the A3-RSRP
+// (hysteresis, per-cell time-to-trigger, 1024 ms periodic reports) or
+// A2-A4-RSRQ (serving threshold, neighbour offset, A4 reports every 480 ms)
+// decision directly. Each quantity is updated in one loop over all UEs
+// (arrays indexed cell * numberOfUes + ue). The antenna gain is read from a
+// table, so the RSRP loop needs no atan2/pow; the dB conversions of the L3
+// filter still call log10 per UE and cell.
+//
+// Assumptions: every cell is fully loaded (RSRQ = RSRP / (12 * total RSRP +
+// noise per RB)), handovers execute instantly, and there is no fading and no
+// radio link failure. Throughput is not modelled and is reported as 0. Only
+// the handover counts and ping-pong rate are meant to be used, and their
+// agreement with full runs is checked with --validateScreening.
+// ---------------------------------------------------------------------------
+
+static const double kScreeningFrequencyHz = 2120e6;   // DL EARFCN 100
+static const uint32_t kScreeningRbs = 100;
+static const double kScreeningNoiseFigureDb = 9.0;    // LteUePhy default
+static const double kScreeningL3FilterA = 0.5;        // filterCoefficient fc4
+static const double kEnbBeamwidthDegrees = 65.0;      // CosineAntennaModel HorizontalBeamwidth
+
+// Cosine antenna gain of every cell towards a point, as CosineAntennaModel
+// computes it: cos(phi / 2)^(2 * exponent), phi being the angle off boresight.
+// Since cos^2(phi / 2) = (1 + cos phi) / 2, the gain only depends on cos phi,
+// which is a dot product with the boresight. The gain is tabulated over
+// cos phi once and linearly interpolated (error below 1e-4 dB down to -60 dB).
+class SectorGainTable {
+public:
+    SectorGainTable(const CellLayout &layout, bool sectored)
+        : m_sectored(sectored), m_table(kTableSize + 1) {
+        for (double orientation : layout.orientations) {
+            m_cos.push_back(std::cos(orientation * M_PI / 180.0));
+            m_sin.push_back(std::sin(orientation * M_PI / 180.0));
+        }
+        const double exponent = -3.0 / (20 * std::log10(std::cos(kEnbBeamwidthDegrees / 4.0 * M_PI / 180.0)));
+        for (uint32_t i = 0; i <= kTableSize; ++i) {
+            double cosPhi = -1.0 + 2.0 * i / kTableSize;
+            m_table[i] = std::pow((1 + cosPhi) / 2, exponent);
+        }
+    }
+
+    // Linear antenna gain of `cell` towards the horizontal offset (dx, dy) from its site
+    double Get(uint32_t cell, double dx, double dy) const {
+        if (!m_sectored) {
+            return 1.0;
+        }
+        double h2 = dx * dx + dy * dy;
+        // Directly above the site atan2 gives 0, i.e. phi = -orientation
+        double cosPhi = h2 > 0 ? (dx * m_cos[cell] + dy * m_sin[cell]) / std::sqrt(h2) : m_cos[cell];
+        double position = std::min(std::max((cosPhi + 1) * (kTableSize / 2), 0.0), double(kTableSize));
+        uint32_t i = std::min(static_cast<uint32_t>(position), kTableSize - 1);
+        return m_table[i] + (position - i) * (m_table[i + 1] - m_table[i]);
+    }
+
+private:
+    static const uint32_t kTableSize = 4096;
+
+    bool m_sectored;
+    std::vector<double> m_cos;
+    std::vector<double> m_sin;
+    std::vector<double> m_table;
+};
+
+struct ScreeningUe {
+    uint32_t serving = 0;
+    uint32_t previous = UINT32_MAX;   // source of the last handover
+    int64_t lastHandoverNs = -1;
+    int64_t nextReportNs = -1;        // A3 periodic report, -1 = none pending
+    int64_t nextA4Ns = 0;             // A2-A4: next neighbour report to the eNB
+};
+
+SimulationResult RunScreening(const SimulationConfig &config) {
+    auto start = std::chrono::steady_clock::now();
+    RngSeedManager::SetRun(config.rngRun);
+    CellLayout layout = BuildLayout(config);
+    UeDrop drop = DrawUeDrop(config, layout);
+    const uint32_t numUes = config.numberOfUes;
+    const uint32_t numCells = layout.positions.size();
+    const int64_t stepNs = config.screenStep.GetNanoSeconds();
+    NS_ABORT_MSG_IF(stepNs <= 0, "screenStep must be positive");
+
+    // Handovers are only possible over X2
+    const uint32_t x2Neighbours = X2NeighbourCount(config);
+    std::vector<uint8_t> x2(uint64_t(numCells) * numCells, x2Neighbours == 0 ? 1 : 0);
+    if (x2Neighbours > 0) {
+        for (auto const &link : FindX2Links(layout.centroids, x2Neighbours, config.interSiteDistance)) {
+            x2[uint64_t(link.first) * numCells + link.second] = 1;
+            x2[uint64_t(link.second) * numCells + link.first] = 1;
+        }
+    }
+
+    // Power per resource element, Friis constant and noise per RB, all in mW
+    const double txPerReMw = std::pow(10.0, config.txPower / 10.0) / (kScreeningRbs * 12);
+    const double lambda = 299792458.0 / kScreeningFrequencyHz;
+    const double friis = lambda * lambda / (16 * M_PI * M_PI);
+    const double noisePerRbMw = std::pow(10.0, (-174.0 + kScreeningNoiseFigureDb) / 10.0) * 180e3;
+    const SectorGainTable antenna(layout, config.sectorsPerSite > 1);
+
+    // UEs move exactly as the mobility models of the full run would move them
+    const UeBoundary boundary = ParseUeBoundary(config.ueBoundary);
+    std::unique_ptr<MobilityTrace> trace;
+    if (!config.mobilityTrace.empty()) {
+        trace.reset(new MobilityTrace(config.mobilityTrace));
+        NS_ABORT_MSG_IF(trace->GetNUes() < numUes, config.mobilityTrace << " has only " << trace->GetNUes() << " UEs");
+    }
+    std::vector<uint64_t> cursors(numUes, 0);
+    std::vector<double> x(numUes), y(numUes);
+    std::vector<double> rsrpMw(uint64_t(numCells) * numUes);
+    std::vector<double> totalMw(numUes);
+    std::vector<double> rsrp(uint64_t(numCells) * numUes);   // L3 filtered, dBm
+    std::vector<double> rsrq(uint64_t(numCells) * numUes);   // L3 filtered, dB
+    std::vector<double> a4Rsrq(uint64_t(numCells) * numUes); // last RSRQ reported by A4
+    std::vector<int64_t> enteredNs(uint64_t(numCells) * numUes, -1);  // A3 condition start
+    std::vector<uint8_t> triggered(uint64_t(numCells) * numUes, 0);   // in the A3 cellsTriggeredList
+    std::vector<ScreeningUe> ues(numUes);
+    // The UE applies the hysteresis as sent in the IE, in 0.5 dB steps
+    const double hysteresis = EutranMeasurementMapping::IeValue2ActualHysteresis(
+        EutranMeasurementMapping::ActualHysteresis2IeValue(config.hysteresis));
+    const int64_t timeToTriggerNs = int64_t(config.timeToTrigger) * 1000000;
+    const int64_t a3ReportIntervalNs = 1024 * 1000000LL;
+    const int64_t a4ReportIntervalNs = 480 * 1000000LL;
+    const int64_t pingPongNs = config.pingPongWindow.GetNanoSeconds();
+    uint32_t handovers = 0;
+    uint32_t pingPongs = 0;
+
+    // RSRQ range as reported (TS 36.133: 0 below -19.5 dB, 34 at -3 dB and above)
+    auto rsrqRange = [](double db) {
+        return std::min(34.0, std::max(0.0, std::floor(2 * (db + 20))));
+    };
+    auto executeHandover = [&](uint32_t u, uint32_t target, int64_t now) {
+        ScreeningUe &ue = ues[u];
+        ++handovers;
+        if (target == ue.previous && now - ue.lastHandoverNs <= pingPongNs) {
+            ++pingPongs;
+        }
+        ue.previous = ue.serving;
+        ue.serving = target;
+        ue.lastHandoverNs = now;
+        ue.nextReportNs = -1;
+        for (uint32_t c = 0; c < numCells; ++c) {
+            enteredNs[uint64_t(c) * numUes + u] = -1;
+            triggered[uint64_t(c) * numUes + u] = 0;
+        }
+    };
+    // A3 report: the eNB hands over to the strongest triggered neighbour
+    auto reportA3 = [&](uint32_t u, int64_t now) {
+        uint32_t best = UINT32_MAX;
+        for (uint32_t c = 0; c < numCells; ++c) {
+            uint64_t i = uint64_t(c) * numUes + u;
+            if (triggered[i] && (best == UINT32_MAX || rsrp[i] > rsrp[uint64_t(best) * numUes + u])) {
+                best = c;
+            }
+        }
+        if (best != UINT32_MAX && x2[uint64_t(ues[u].serving) * numCells + best]) {
+            executeHandover(u, best, now);
+        } else if (best != UINT32_MAX) {
+            ues[u].nextReportNs = now + a3ReportIntervalNs;  // refused without X2, reported again later
+        }
+    };
+
+    for (int64_t now = 0; now <= config.simTime.GetNanoSeconds(); now += stepNs) {
+        // A3 time-to-trigger expiries and periodic reports due since the last measurement
+        if (!config.useA2A4 && now > 0) {
+            for (uint32_t u = 0; u < numUes; ++u) {
+                int64_t reportAt = -1;
+                for (uint32_t c = 0; c < numCells; ++c) {
+                    uint64_t i = uint64_t(c) * numUes + u;
+                    if (enteredNs[i] >= 0 && !triggered[i] && timeToTriggerNs > 0 && enteredNs[i] + timeToTriggerNs <= now) {
+                        triggered[i] = 1;
+                        int64_t expiry = enteredNs[i] + timeToTriggerNs;
+                        reportAt = reportAt < 0 ? expiry : std::min(reportAt, expiry);
+                    }
+                }
+                if (ues[u].nextReportNs >= 0 && ues[u].nextReportNs <= now) {
+                    reportAt = reportAt < 0 ? ues[u].nextReportNs : std::min(reportAt, ues[u].nextReportNs);
+                }
+                if (reportAt >= 0) {
+                    ues[u].nextReportNs = reportAt + a3ReportIntervalNs;
+                    reportA3(u, reportAt);
+                }
+            }
+        }
+
+        // New measurement: positions, RSRP for every cell, total received power
+        double t = now / 1e9;
+        for (uint32_t u = 0; u < numUes; ++u) {
+            Vector position = trace ? trace->GetPosition(u, t, cursors[u])
+                                    : BoundedPosition(drop.positions[u], drop.velocities[u], t, layout.width,
+                                                      layout.height, boundary);
+            x[u] = position.x;
+            y[u] = position.y;
+        }
+        std::fill(totalMw.begin(), totalMw.end(), 0.0);
+        for (uint32_t c = 0; c < numCells; ++c) {
+            const double cx = layout.positions[c].x;
+            const double cy = layout.positions[c].y;
+            const double cz = layout.positions[c].z;
+            double *cellRsrp = &rsrpMw[uint64_t(c) * numUes];
+            for (uint32_t u = 0; u < numUes; ++u) {
+                double dx = x[u] - cx;
+                double dy = y[u] - cy;
+                double d2 = std::max(dx * dx + dy * dy + cz * cz, 1.0);
+                cellRsrp[u] = txPerReMw * antenna.Get(c, dx, dy) * friis / d2;
+                totalMw[u] += cellRsrp[u];
+            }
+        }
+        // L3 filtered RSRP (dBm) and RSRQ (dB)
+        for (uint32_t c = 0; c < numCells; ++c) {
+            for (uint32_t u = 0; u < numUes; ++u) {
+                uint64_t i = uint64_t(c) * numUes + u;
+                double mw = std::max(rsrpMw[i], 1e-30);
+                double rsrpDbm = 10 * std::log10(mw);
+                double rsrqDb = 10 * std::log10(mw / (12 * totalMw[u] + noisePerRbMw));
+                rsrp[i] = now == 0 ? rsrpDbm : (1 - kScreeningL3FilterA) * rsrp[i] + kScreeningL3FilterA * rsrpDbm;
+                rsrq[i] = now == 0 ? rsrqDb : (1 - kScreeningL3FilterA) * rsrq[i] + kScreeningL3FilterA * rsrqDb;
+            }
+        }
+
+        if (now == 0) {
+            // Initial cell selection: strongest RSRP
+            for (uint32_t u = 0; u < numUes; ++u) {
+                uint32_t best = 0;
+                for (uint32_t c = 1; c < numCells; ++c) {
+                    if (rsrp[uint64_t(c) * numUes + u] > rsrp[uint64_t(best) * numUes + u]) {
+                        best = c;
+                    }
+                }
+                ues[u].serving = best;
+            }
+            continue;
+        }
+
+        if (!config.useA2A4) {
+            // A3 entering condition Mn - Hys > Ms (a3Offset 0); leaving it cancels the cell
+            for (uint32_t u = 0; u < numUes; ++u) {
+                double serving = rsrp[uint64_t(ues[u].serving) * numUes + u];
+                bool reportNow = false;
+                for (uint32_t c = 0; c < numCells; ++c) {
+                    uint64_t i = uint64_t(c) * numUes + u;
+                    bool entering = c != ues[u].serving && rsrp[i] - hysteresis > serving;
+                    if (!entering) {
+                        enteredNs[i] = -1;
+                        triggered[i] = 0;
+                    } else if (enteredNs[i] < 0) {
+                        enteredNs[i] = now;
+                        if (timeToTriggerNs == 0) {
+                            triggered[i] = 1;
+                            reportNow = true;
+                        }
+                    }
+                }
+                if (reportNow) {
+                    ues[u].nextReportNs = now + a3ReportIntervalNs;
+                    reportA3(u, now);
+                }
+            }
+        } else {
+            for (uint32_t u = 0; u < numUes; ++u) {
+                ScreeningUe &ue = ues[u];
+                // A4 (threshold range 0) reports every neighbour to the eNB every 480 ms
+                if (now >= ue.nextA4Ns) {
+                    for (uint32_t c = 0; c < numCells; ++c) {
+                        a4Rsrq[uint64_t(c) * numUes + u] = rsrq[uint64_t(c) * numUes + u];
+                    }
+                    while (ue.nextA4Ns <= now) {
+                        ue.nextA4Ns += a4ReportIntervalNs;
+                    }
+                }
+                // A2 (no time-to-trigger): serving RSRQ below the threshold
+                double servingRange = rsrqRange(rsrq[uint64_t(ue.serving) * numUes + u]);
+                if (servingRange >= config.servingCellThreshold) {
+                    continue;
+                }
+                uint32_t best = UINT32_MAX;
+                double bestRange = 0.0;
+                for (uint32_t c = 0; c < numCells; ++c) {
+                    double range = rsrqRange(a4Rsrq[uint64_t(c) * numUes + u]);
+                    if (c != ue.serving && range > 0 && (best == UINT32_MAX || range > bestRange)) {
+                        best = c;
+                        bestRange = range;
+                    }
+                }
+                if (best != UINT32_MAX && bestRange - servingRange >= config.neighbourCellOffset &&
+                    x2[uint64_t(ue.serving) * numCells + best]) {
+                    executeHandover(u, best, now);
+                }
+            }
+        }
+    }
+
+    SimulationResult result;
+    result.handoverCount = handovers;
+    double seconds = config.simTime.GetSeconds();
+    if (numUes > 0 && seconds > 0) {
+        result.anoh = double(handovers) / (numUes * seconds);
+    }
+    result.pingPongRate = handovers > 0 ? double(pingPongs) / handovers : 0.0;
+    result.events = uint64_t(numUes) * (config.simTime.GetNanoSeconds() / stepNs + 1);  // UE measurements evaluated
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.peakRssKb = ReadProcKb("/proc/self/status", "VmHWM");
+    return result;
+}
+
+// Initial cell selection from geometry alone: the strongest RSRP under the
+// screening propagation model. Transmit power and the Friis constant are the
+// same for every cell, so only antenna gain over squared distance is compared.
+// Fading is ignored, so with enableFading the protocol stack's own cell search
+// could have picked another cell.
+std::vector<uint32_t> SelectCellsByGeometry(const SimulationConfig &config, const CellLayout &layout,
+                                            const std::vector<Vector> &positions) {
+    const SectorGainTable antenna(layout, config.sectorsPerSite > 1);
+    std::vector<uint32_t> cells(positions.size(), 0);
+    for (uint32_t u = 0; u < positions.size(); ++u) {
+        double best = -1.0;
+        for (uint32_t c = 0; c < layout.positions.size(); ++c) {
+            double dx = positions[u].x - layout.positions[c].x;
+            double dy = positions[u].y - layout.positions[c].y;
+            double dz = positions[u].z - layout.positions[c].z;
+            double received = antenna.Get(c, dx, dy) / std::max(dx * dx + dy * dy + dz * dz, 1.0);
+            if (received > best) {
+                best = received;
+                cells[u] = c;
+            }
+        }
+    }
+    return cells;
+}
+
+// Attach a batch of UEs straight to their geometry-selected cells. Attaching
+// while the simulation runs is valid with the ns-3.41 EPC: LteHelper::Attach
+// makes the NAS camp on the cell and start the RRC connection, and
+// NoBackhaulEpcHelper::ActivateEpsBearer registers the default bearer with
+// the MME and schedules its activation on the UE NAS with ScheduleNow. Both
+// only need the UE to be installed in the EPC and to have its IP address,
+// which BuildScenario does before t = 0. The UE must not have been attached
+// yet; g_allConnectedSeconds stays -1 if some UE never connects.
+void AttachBatch(Ptr<LteHelper> lteHelper, NetDeviceContainer ueDevs, NetDeviceContainer enbDevs) {
+    for (uint32_t i = 0; i < ueDevs.GetN(); ++i) {
+        Ptr<EpcUeNas> nas = ueDevs.Get(i)->GetObject<LteUeNetDevice>()->GetNas();
+        NS_ABORT_MSG_IF(nas->GetState() != EpcUeNas::OFF, "UE " << i << " of the attach batch is already attached");
+        lteHelper->Attach(ueDevs.Get(i), enbDevs.Get(i));
+    }
+}
+
+// What a run keeps between building the scenario and reading the KPIs
+struct Scenario {
+    Ptr<LteHelper> lteHelper;
+    NetDeviceContainer enbDevs;
+    NetDeviceContainer ueDevs;
+    std::unique_ptr<FlowMonitorHelper> flowmonHelper;
+    Ptr<FlowMonitor> flowmon;
+    uint16_t dlPort = 10000;
+};
+
+// Build nodes, devices, applications and trace hooks; the simulator is not run
+void BuildScenario(const SimulationConfig &config, Scenario &scenario) {
+    // Must precede every other Simulator call of the run
+    if (!config.telemetry.empty() || config.queueStats) {
+        Ptr<TelemetrySimulatorImpl> impl = CreateObject<TelemetrySimulatorImpl>();
+        if (!config.telemetry.empty()) {
+            impl->Open(config.telemetry, config.telemetryPeriod);
+        }
+        Simulator::SetImplementation(impl);
+        g_telemetry = PeekPointer(impl);
+    }
+    g_handoverCount = 0;
+    g_connectedUes.clear();
+    g_expectedUes = config.numberOfUes;
+    g_allConnectedSeconds = -1.0;
+    RngSeedManager::SetRun(config.rngRun);
+    bool saturated = config.trafficMode == "saturated";
+    NS_ABORT_MSG_IF(!saturated && config.trafficMode != "tcp", "Unknown trafficMode " << config.trafficMode);
+    NS_ABORT_MSG_IF(saturated && (config.disableDl || config.disableUl),
+                    "trafficMode=saturated always loads both directions; disableDl/disableUl need trafficMode=tcp");
+    bool rlcThroughput = saturated || config.rlcThroughput;
+
+    if (config.useA2A4 && config.verbose)
+    {
+    std::cout << "*** DEBUG: A2-A4 parameters: "
+                << "servingCellThreshold=" << (int)config.servingCellThreshold
+                << " dB, neighbourCellOffset="   << (int)config.neighbourCellOffset
+                << " dB\n";
+    }
+
+    // Configure default application behavior
+    Config::SetDefault("ns3::UdpClient::Interval", TimeValue(MilliSeconds(10)));
+    Config::SetDefault("ns3::UdpClient::MaxPackets", UintegerValue(1000000));
+    Config::SetDefault ("ns3::LteHelper::UseIdealRrc", BooleanValue (true));
+    Config::SetDefault("ns3::TcpSocket::SegmentSize", UintegerValue(1024));
+
+    // Create LTE and EPC helpers
+    Ptr<LteHelper> lteHelper = CreateObject<LteHelper>();
+    Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper>();
+    lteHelper->SetEpcHelper(epcHelper);
+    lteHelper->SetSchedulerType("ns3::RrFfMacScheduler");
+    
+    //lteHelper->SetSchedulerType("ns3::PfFfMacScheduler");
+    //std::cout << "Using Proportional Fair Scheduler" << std::endl;
+
+    //lteHelper->EnableTraces();
+    // Disable LTE RLC/PDCP statistics to avoid handover crashes
+    //lteHelper->SetAttribute("EnableRlcStats", BooleanValue(false));  
+    //lteHelper->SetAttribute("EnablePdcpStats", BooleanValue(false)); 
+    // (We do not call EnableTraces(), to avoid creating LteStatsCalculator modules that caused errors)
+
+    // Configure the selected handover algorithm and its parameters
+    if (!g_handoverVariants.empty()) {
+    lteHelper->SetHandoverAlgorithmType("ns3::BranchedHandoverAlgorithm");
+    }
+    else if (config.useA2A4) {
+    lteHelper->SetHandoverAlgorithmType("ns3::A2A4RsrqHandoverAlgorithm");
+    lteHelper->SetHandoverAlgorithmAttribute("ServingCellThreshold", UintegerValue(config.servingCellThreshold));
+    lteHelper->SetHandoverAlgorithmAttribute("NeighbourCellOffset", UintegerValue(config.neighbourCellOffset));
+    }
+    else {
+    lteHelper->SetHandoverAlgorithmType("ns3::A3RsrpHandoverAlgorithm");
+    lteHelper->SetHandoverAlgorithmAttribute("Hysteresis", DoubleValue(config.hysteresis));
+    lteHelper->SetHandoverAlgorithmAttribute("TimeToTrigger", TimeValue(MilliSeconds(config.timeToTrigger)));
+    }
+
+    // Set fading model (if enabled) using a trace file (EVA or ETU as appropriate):contentReference[oaicite:11]{index=11}
+    // A converted binary trace is mapped read-only instead of parsed into every process
+    if (config.enableFading) {
+        bool mapped = IsMappedFadingTrace(config.fadingTrace);
+        lteHelper->SetAttribute("FadingModel", StringValue(mapped ? "ns3::MappedTraceFadingLossModel"
+                                                                  : "ns3::TraceFadingLossModel"));
+        lteHelper->SetFadingModelAttribute("TraceFilename", StringValue(config.fadingTrace));
+        lteHelper->SetFadingModelAttribute("WindowSize", TimeValue(Seconds(0.5)));
+        lteHelper->SetFadingModelAttribute("SamplesNum", UintegerValue(config.fadingSamples));
+    }
+
+    // Set LTE eNB parameters (frequency, bandwidth, tx power, etc.):contentReference[oaicite:12]{index=12}
+    lteHelper->SetEnbDeviceAttribute("DlEarfcn", UintegerValue(100));
+    lteHelper->SetEnbDeviceAttribute("UlEarfcn", UintegerValue(18100));
+    lteHelper->SetEnbDeviceAttribute("DlBandwidth", UintegerValue(100));  // 5 MHz (25 RBs)
+    lteHelper->SetEnbDeviceAttribute("UlBandwidth", UintegerValue(100));
+    Config::SetDefault("ns3::LteEnbPhy::TxPower", DoubleValue(config.txPower));
+
+    // Create PGW (Packet Gateway) and a remote host for internet traffic
+    Ptr<Node> pgw = epcHelper->GetPgwNode();
+    NodeContainer remoteHostContainer;
+    remoteHostContainer.Create(1);
+    Ptr<Node> remoteHost = remoteHostContainer.Get(0);
+    InternetStackHelper internet;
+    internet.Install(remoteHostContainer);
+
+    // Connect remoteHost to PGW with a high-capacity P2P link
+    PointToPointHelper p2ph;
+    p2ph.SetDeviceAttribute("DataRate", DataRateValue(DataRate("100Gb/s")));
+    p2ph.SetDeviceAttribute("Mtu", UintegerValue(1500));
+    p2ph.SetChannelAttribute("Delay", TimeValue(MilliSeconds(0.010)));
+    NetDeviceContainer internetDevices = p2ph.Install(pgw, remoteHost);
+    Ipv4AddressHelper ipv4h;
+    ipv4h.SetBase("1.0.0.0", "255.0.0.0");
+    Ipv4InterfaceContainer internetIpIfaces = ipv4h.Assign(internetDevices);
+    Ipv4Address remoteHostAddr = internetIpIfaces.GetAddress(1);
+
+    // Add a route from the remoteHost to the LTE network (UE subnet 7.0.0.0)
+    Ipv4StaticRoutingHelper ipv4RoutingHelper;
+    Ptr<Ipv4StaticRouting> remoteHostStaticRouting = 
+        ipv4RoutingHelper.GetStaticRouting(remoteHost->GetObject<Ipv4>());
+    remoteHostStaticRouting->AddNetworkRouteTo(Ipv4Address("7.0.0.0"), Ipv4Mask("255.0.0.0"), 1);
+
+    // Create eNB and UE nodes
+    CellLayout layout = BuildLayout(config);
+    NodeContainer enbNodes;
+    NodeContainer ueNodes;
+    enbNodes.Create(layout.positions.size());
+    ueNodes.Create(config.numberOfUes);
+
+    // Position the eNBs on the site grid, with co-located sector cells per site:contentReference[oaicite:13]{index=13}
+    Ptr<ListPositionAllocator> enbPositionAlloc = CreateObject<ListPositionAllocator>();
+    for (auto const &position : layout.positions) {
+        enbPositionAlloc->Add(position);
+    }
+    MobilityHelper enbMobility;
+    enbMobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    enbMobility.SetPositionAllocator(enbPositionAlloc);
+    enbMobility.Install(enbNodes);
+
+    // Install mobility model for UEs: waypoint trace, or random initial position and constant velocity
+    MobilityHelper ueMobility;
+    UeBoundary boundary = ParseUeBoundary(config.ueBoundary);
+    UeDrop drop = DrawUeDrop(config, layout);
+    if (!config.mobilityTrace.empty()) {
+        auto trace = std::make_shared<const MobilityTrace>(config.mobilityTrace);
+        NS_ABORT_MSG_IF(trace->GetNUes() < config.numberOfUes,
+                        config.mobilityTrace << " has only " << trace->GetNUes() << " UEs");
+        ueMobility.SetMobilityModel("ns3::TraceMobilityModel");
+        ueMobility.Install(ueNodes);
+        for (uint32_t u = 0; u < ueNodes.GetN(); ++u) {
+            ueNodes.Get(u)->GetObject<TraceMobilityModel>()->SetTrace(trace, u);
+        }
+    } else if (boundary != BOUNDARY_NONE) {
+        ueMobility.SetMobilityModel("ns3::BoundedVelocityMobilityModel");
+        ueMobility.Install(ueNodes);
+        for (uint32_t u = 0; u < ueNodes.GetN(); ++u) {
+            Ptr<BoundedVelocityMobilityModel> mob = ueNodes.Get(u)->GetObject<BoundedVelocityMobilityModel>();
+            mob->SetPosition(drop.positions[u]);
+            mob->SetVelocity(drop.velocities[u], layout.width, layout.height, boundary);
+        }
+    } else {
+        ueMobility.SetMobilityModel("ns3::ConstantVelocityMobilityModel");
+        ueMobility.Install(ueNodes);
+        for (uint32_t u = 0; u < ueNodes.GetN(); ++u) {
+            Ptr<ConstantVelocityMobilityModel> mob = ueNodes.Get(u)->GetObject<ConstantVelocityMobilityModel>();
+            mob->SetPosition(drop.positions[u]);
+            mob->SetVelocity(drop.velocities[u]);
+        }
+    }
+    
+    // Set antenna model type BEFORE installing eNBs (omni sites have no sectors to point)
+    if (config.sectorsPerSite > 1) {
+        lteHelper->SetEnbAntennaModelType("ns3::CosineAntennaModel");
+        lteHelper->SetEnbAntennaModelAttribute("HorizontalBeamwidth", DoubleValue(kEnbBeamwidthDegrees));
+    } else {
+        lteHelper->SetEnbAntennaModelType("ns3::IsotropicAntennaModel");
+    }
+
+    // Install eNBs with sector-specific orientations
+    NetDeviceContainer enbDevs;
+    for (uint32_t i = 0; i < enbNodes.GetN(); i++) {
+        if (config.sectorsPerSite > 1) {
+            lteHelper->SetEnbAntennaModelAttribute("Orientation", DoubleValue(layout.orientations[i]));
+        }
+        Ptr<NetDevice> enbDev = lteHelper->InstallEnbDevice(enbNodes.Get(i)).Get(0);
+        enbDevs.Add(enbDev);
+    }
+
+    // Saturated bearers: RLC SM keeps every DRB backlogged at whatever the scheduler
+    // grants, in both directions. In ns-3.41, LteHelper::InstallSingleEnbDevice
+    // replaces RLC_SM_ALWAYS with RLC_UM_ALWAYS whenever an EPC is present, so a
+    // Config::SetDefault before InstallEnbDevice would be undone; the mapping is set
+    // again here, after the install but before any bearer exists. Recheck this on
+    // ns-3 upgrades.
+    if (saturated) {
+        for (uint32_t i = 0; i < enbDevs.GetN(); ++i) {
+            enbDevs.Get(i)->GetObject<LteEnbNetDevice>()->GetRrc()->SetAttribute(
+                "EpsBearerToRlcMapping", EnumValue(LteEnbRrc::RLC_SM_ALWAYS));
+        }
+    }
+
+    if (config.sectorsPerSite > 1) {
+        lteHelper->SetEnbAntennaModelAttribute("Orientation", DoubleValue(0.0)); // Reset
+    }
+	
+    NetDeviceContainer ueDevs  = lteHelper->InstallUeDevice(ueNodes);
+    internet.Install(ueNodes);
+    Ipv4InterfaceContainer ueIpIfaces = epcHelper->AssignUeIpv4Address(NetDeviceContainer(ueDevs));
+    if (saturated) {
+        for (uint32_t i = 0; i < ueDevs.GetN(); ++i) {
+            ueDevs.Get(i)->GetObject<LteUeNetDevice>()->GetRrc()->SetUseRlcSm(true);
+        }
+    }
+
+    // Attach each UE to the best available cell (initial cell selection). With
+    // attachRamp the cells are chosen in bulk from geometry, and the UEs attach
+    // straight to them in batches spread over the ramp, instead of all running
+    // their cell search and RRC connection in the first milliseconds.
+    std::vector<double> attachAt(ueDevs.GetN(), 0.0);
+    if (config.attachRamp.IsStrictlyPositive()) {
+        std::vector<Vector> positions;
+        for (uint32_t u = 0; u < ueNodes.GetN(); ++u) {
+            positions.push_back(ueNodes.Get(u)->GetObject<MobilityModel>()->GetPosition());
+        }
+        std::vector<uint32_t> cells = SelectCellsByGeometry(config, layout, positions);
+        uint32_t batches = std::max(1u, std::min(config.attachBatches, ueDevs.GetN()));
+        for (uint32_t b = 0; b < batches; ++b) {
+            NetDeviceContainer batchUes;
+            NetDeviceContainer batchEnbs;
+            double at = config.attachRamp.GetSeconds() * b / batches;
+            for (uint32_t u = uint64_t(ueDevs.GetN()) * b / batches; u < uint64_t(ueDevs.GetN()) * (b + 1) / batches; ++u) {
+                batchUes.Add(ueDevs.Get(u));
+                batchEnbs.Add(enbDevs.Get(cells[u]));
+                attachAt[u] = at;
+            }
+            Simulator::Schedule(Seconds(at), &AttachBatch, lteHelper, batchUes, batchEnbs);
+        }
+    } else {
+        for (uint32_t i = 0; i < ueDevs.GetN(); ++i) {
+            lteHelper->Attach(ueDevs.Get(i));  // UE will automatically connect to strongest eNB
+        }
+    }
+
+    // Install traffic applications: full-buffer TCP downlink and uplink for each UE:contentReference[oaicite:14]{index=14}
+    // (none with saturated bearers, which generate their own traffic inside RLC)
+    uint16_t dlPort = 10000;
+    uint16_t ulPort = 20000;
+    Ptr<UniformRandomVariable> startVar = CreateObject<UniformRandomVariable>();
+    startVar->SetAttribute("Min", DoubleValue(0));
+    startVar->SetAttribute("Max", DoubleValue(0.010));
+    std::vector<Ptr<Application>> dlSinks(ueNodes.GetN());
+    std::vector<Ptr<Application>> ulSinks(ueNodes.GetN());
+    for (uint32_t u = 0; u < ueNodes.GetN(); ++u) {
+        Ptr<Node> ueNode = ueNodes.Get(u);
+        Ptr<Ipv4StaticRouting> ueStaticRouting = ipv4RoutingHelper.GetStaticRouting(ueNode->GetObject<Ipv4>());
+        ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
+
+        // Downlink: OnOff application from remoteHost -> UE (acts as full-buffer traffic source)
+        if (!config.disableDl && !saturated) {
+            OnOffHelper dlClient("ns3::TcpSocketFactory", InetSocketAddress(ueIpIfaces.GetAddress(u), dlPort + u));
+            dlClient.SetAttribute("DataRate", DataRateValue(DataRate("10Gbps")));
+            dlClient.SetAttribute("PacketSize", UintegerValue(1400));
+            // Ensure the OnOff application is always "on" (no idle time) for full buffer traffic
+            dlClient.SetAttribute("OnTime", StringValue("ns3::ConstantRandomVariable[Constant=1]"));
+            dlClient.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0]"));
+            ApplicationContainer dlApps = dlClient.Install(remoteHost);
+            // Sink on UE to receive downlink traffic
+            PacketSinkHelper dlSink("ns3::TcpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), dlPort + u));
+            ApplicationContainer dlSinkApps = dlSink.Install(ueNode);
+            dlSinks[u] = dlSinkApps.Get(0);
+            dlApps.Start(Seconds(attachAt[u] + startVar->GetValue()));
+            dlSinkApps.Start(Seconds(attachAt[u] + startVar->GetValue()));
+            dlApps.Stop(config.simTime);
+            dlSinkApps.Stop(config.simTime);
+        }
+
+        // Uplink: OnOff application from UE -> remoteHost (full-buffer uplink source)
+        if (!config.disableUl && !saturated) {
+            OnOffHelper ulClient("ns3::TcpSocketFactory", InetSocketAddress(remoteHostAddr, ulPort + u));
+            ulClient.SetAttribute("DataRate", DataRateValue(DataRate("10Gbps")));
+            ulClient.SetAttribute("PacketSize", UintegerValue(1400));
+            ulClient.SetAttribute("OnTime", StringValue("ns3::ConstantRandomVariable[Constant=1]"));
+            ulClient.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0]"));
+            ApplicationContainer ulApps = ulClient.Install(ueNode);
+            // Sink on remote host to receive uplink traffic
+            PacketSinkHelper ulSink("ns3::TcpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), ulPort + u));
+            ApplicationContainer ulSinkApps = ulSink.Install(remoteHost);
+            ulSinks[u] = ulSinkApps.Get(0);
+            ulApps.Start(Seconds(attachAt[u] + startVar->GetValue()));
+            ulSinkApps.Start(Seconds(attachAt[u] + startVar->GetValue()));
+            ulApps.Stop(config.simTime);
+            ulSinkApps.Stop(config.simTime);
+        }
+    }
+
+    // Enable X2 interface (needed for X2-based handover between eNBs). With x2Neighbours set
+    // (or by default beyond one tier), each cell only gets links to its nearest cells instead of
+    // the O(N^2) full mesh; the eNB ANR then refuses handovers towards cells without an X2 link.
+    const uint32_t x2Neighbours = X2NeighbourCount(config);
+    if (x2Neighbours == 0) {
+        lteHelper->AddX2Interface(enbNodes);
+    } else {
+        for (auto const &link : FindX2Links(layout.centroids, x2Neighbours, config.interSiteDistance)) {
+            lteHelper->AddX2Interface(enbNodes.Get(link.first), enbNodes.Get(link.second));
+        }
+    }
+
+    // (No manual handover triggers; rely on algorithm-driven handovers)
+
+    //lteHelper->EnablePhyTraces();
+    //lteHelper->EnableMacTraces();
+    //lteHelper->EnableRlcTraces();
+    //lteHelper->EnablePdcpTraces();
+    //Ptr<RadioBearerStatsCalculator> rlcStats = lteHelper->GetRlcStats();
+    //rlcStats->SetAttribute("EpochDuration", TimeValue(Seconds(1.0)));
+    //Ptr<RadioBearerStatsCalculator> pdcpStats = lteHelper->GetPdcpStats();
+    //pdcpStats->SetAttribute("EpochDuration", TimeValue(Seconds(1.0)));
+
+    // Count completed handovers and first connections on the UE side, independently of event logging
+    for (uint32_t i = 0; i < ueDevs.GetN(); ++i) {
+        Ptr<LteUeRrc> rrc = ueDevs.Get(i)->GetObject<LteUeNetDevice>()->GetRrc();
+        rrc->TraceConnectWithoutContext("HandoverEndOk", MakeCallback(&HandoverEndOkCounter));
+        rrc->TraceConnectWithoutContext("ConnectionEstablished", MakeCallback(&ConnectionEstablishedCounter));
+    }
+
+    if (config.handoverStats || !config.handoverStatsFile.empty()) {
+        std::vector<uint64_t> imsis;
+        for (uint32_t u = 0; u < ueDevs.GetN(); ++u) {
+            imsis.push_back(ueDevs.Get(u)->GetObject<LteUeNetDevice>()->GetImsi());
+        }
+        g_handoverAnalytics.reset(new HandoverAnalytics(imsis, enbDevs.GetN(), config.pingPongWindow, config.rlfWindow));
+        ConnectHandoverAnalytics(enbDevs, ueDevs);
+    }
+
+    // Connection and handover logging: text on stdout, binary ring buffer with --eventLog, or nothing
+    if (config.verbose) {
+        if (!config.eventLog.empty()) {
+            g_eventRecorder.reset(new EventRecorder(config.eventLog, config.eventBufferSize));
+        }
+        ConnectEventLogging(enbDevs, ueDevs);
+    }
+
+    // Streaming KPI collector on the UE and remote host sinks only
+    if (!config.kpiFile.empty() || !config.flowMonitor || rlcThroughput) {
+        std::vector<uint64_t> imsis;
+        for (uint32_t u = 0; u < ueDevs.GetN(); ++u) {
+            imsis.push_back(ueDevs.Get(u)->GetObject<LteUeNetDevice>()->GetImsi());
+        }
+        g_kpiCollector.reset(new KpiCollector(config.kpiFile, config.kpiInterval, imsis, enbDevs.GetN()));
+        for (uint32_t u = 0; u < ueDevs.GetN(); ++u) {
+            if (dlSinks[u] && !rlcThroughput) {
+                dlSinks[u]->TraceConnectWithoutContext("Rx", MakeBoundCallback(&KpiDlRx, u));
+            }
+            if (ulSinks[u]) {
+                ulSinks[u]->TraceConnectWithoutContext("Rx", MakeBoundCallback(&KpiUlRx, u));
+            }
+            Ptr<LteUeRrc> rrc = ueDevs.Get(u)->GetObject<LteUeNetDevice>()->GetRrc();
+            rrc->TraceConnectWithoutContext("ConnectionEstablished", MakeBoundCallback(&KpiServingCell, u));
+            rrc->TraceConnectWithoutContext("HandoverEndOk", MakeBoundCallback(&KpiServingCell, u));
+        }
+        if (rlcThroughput) {
+            for (uint32_t u = 0; u < ueDevs.GetN(); ++u) {
+                Ptr<LteUeRrc> rrc = ueDevs.Get(u)->GetObject<LteUeNetDevice>()->GetRrc();
+                rrc->TraceConnectWithoutContext("DrbCreated",
+                                                MakeBoundCallback(&KpiRlcDrbCreated, u, PeekPointer(rrc)));
+            }
+        }
+    }
+
+    // Install FlowMonitor on all nodes to collect flow performance statistics
+    // (there are no IP flows to measure with saturated bearers)
+    scenario.flowmonHelper.reset(new FlowMonitorHelper);
+    if (config.flowMonitor && !rlcThroughput) {
+        scenario.flowmon = scenario.flowmonHelper->InstallAll();
+    }
+
+    scenario.lteHelper = lteHelper;
+    scenario.enbDevs = enbDevs;
+    scenario.ueDevs = ueDevs;
+    scenario.dlPort = dlPort;
+}
+
+// Downlink bytes received so far
+uint64_t GetDownlinkBytes(const SimulationConfig &config, Scenario &scenario) {
+    uint64_t totalDlBytes = 0;
+    if (config.flowMonitor && config.trafficMode != "saturated" && !config.rlcThroughput) {
+        scenario.flowmon->CheckForLostPackets();
+        Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(scenario.flowmonHelper->GetClassifier());
+        std::map<FlowId, FlowMonitor::FlowStats> stats = scenario.flowmon->GetFlowStats();
+        for (auto const &flowPair : stats) {
+            Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(flowPair.first);
+            // Sum all downlink flows (remoteHost -> UE) by checking port range
+            if (t.destinationPort >= scenario.dlPort && t.destinationPort < scenario.dlPort + config.numberOfUes) {
+                totalDlBytes += flowPair.second.rxBytes;
+            }
+        }
+    } else {
+        // Application-layer bytes from the sinks (excluding the IP/TCP headers FlowMonitor
+        // counts), or RLC PDU bytes with saturated bearers / rlcThroughput
+        totalDlBytes = g_kpiCollector->GetTotalDlBytes();
+    }
+    return totalDlBytes;
+}
+
+// Throughput, ANOH and optimization ratio over a measurement window
+SimulationResult ComputeResult(const SimulationConfig &config, uint64_t dlBytes, uint32_t handovers, Time window) {
+    SimulationResult result;
+    double simulationTimeSeconds = window.GetSeconds();
+    result.throughputMbps = (dlBytes * 8.0) / (simulationTimeSeconds * 1e6);
+    result.handoverCount = handovers;
+
+    // Calculate Average Number of Handover (ANOH) and Optimize Ratio as defined in the paper
+    if (config.numberOfUes > 0 && simulationTimeSeconds > 0) {
+        result.anoh = (double) handovers / (config.numberOfUes * simulationTimeSeconds);
+    }
+    if (result.anoh > 0.0) {
+        result.optimizationRatio = result.throughputMbps / result.anoh;
+    }
+    return result;
+}
+
+// Copy the handover analytics into the result, report them and write the per-cell table
+void FinishHandoverStats(const std::string &cellTable, SimulationResult &result) {
+    if (!g_handoverAnalytics) {
+        return;
+    }
+    uint32_t handovers = g_handoverAnalytics->GetHandovers();
+    result.pingPongRate = handovers > 0 ? double(g_handoverAnalytics->GetPingPongs()) / handovers : 0.0;
+    result.tooEarly = g_handoverAnalytics->GetTooEarly();
+    result.tooLate = g_handoverAnalytics->GetTooLate();
+    result.handoverFailures = g_handoverAnalytics->GetFailures();
+    result.interruptionMs = g_handoverAnalytics->GetMeanInterruptionMs();
+    g_handoverAnalytics->Print(std::cout);
+    if (!cellTable.empty()) {
+        g_handoverAnalytics->WriteCellTable(cellTable);
+    }
+}
+
+// Time until every UE had connected and the peak queue depth, for a run that started at `start`
+void FinishStartupStats(std::chrono::steady_clock::time_point start, SimulationResult &result) {
+    result.connectedSeconds = g_allConnectedSeconds;
+    result.connectedWallSeconds =
+        g_allConnectedSeconds < 0.0 ? -1.0 : std::chrono::duration<double>(g_allConnectedWall - start).count();
+    result.peakQueueDepth = g_telemetry ? g_telemetry->GetPeakQueueDepth() : 0;
+}
+
+// Close the recorders and release the simulator
+void TeardownScenario() {
+    if (g_eventRecorder) {
+        g_eventRecorder->Stop();
+        g_eventRecorder.reset();
+    }
+    g_kpiCollector.reset();
+    g_handoverAnalytics.reset();
+    if (g_telemetry) {
+        g_telemetry->Close();
+        g_telemetry = nullptr;
+    }
+    Simulator::Destroy();
+}
+
+// Build the scenario, run it to simTime and compute the KPIs
+SimulationResult RunSimulation(const SimulationConfig &config) {
+    if (config.screen) {
+        return RunScreening(config);
+    }
+    auto start = std::chrono::steady_clock::now();
+    Scenario scenario;
+    BuildScenario(config, scenario);
+    Simulator::Stop(config.simTime);
+    Simulator::Run();
+    SimulationResult result = ComputeResult(config, GetDownlinkBytes(config, scenario), g_handoverCount, config.simTime);
+    FinishHandoverStats(config.handoverStatsFile, result);
+    result.events = Simulator::GetEventCount();
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.peakRssKb = ReadProcKb("/proc/self/status", "VmHWM");
+    FinishStartupStats(start, result);
+    TeardownScenario();
+    return result;
+}
+
+// Print the end-of-run KPIs in the usual text format
+void PrintResult(const SimulationResult &result) {
+    std::cout << "Total Downlink Throughput: " << result.throughputMbps << " Mbps" << std::endl;
+    std::cout << "ANOH (Avg handovers per UE per second): " << result.anoh << std::endl;
+    if (result.anoh > 0.0) {
+        std::cout << "Optimization Ratio (Throughput/ANOH): " << result.optimizationRatio << std::endl;
+    } else {
+        std::cout << "Optimization Ratio: N/A (no handovers occurred)" << std::endl;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Replication statistics
+//
+// Running mean / variance (Welford) and the Student t quantiles needed for
+// confidence intervals over independent replications.
+// ---------------------------------------------------------------------------
+
+class RunningStat {
+public:
+    void Add(double x) {
+        ++m_count;
+        double delta = x - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (x - m_mean);
+    }
+
+    uint32_t GetCount() const {
+        return m_count;
+    }
+    double GetMean() const {
+        return m_mean;
+    }
+    double GetVariance() const {
+        return m_count > 1 ? m_m2 / (m_count - 1) : 0.0;
+    }
+    // Half width of the two-sided confidence interval around the mean
+    double GetHalfWidth(double confidence) const;
+
+private:
+    uint32_t m_count = 0;
+    double m_mean = 0.0;
+    double m_m2 = 0.0;
+};
+
+// Inverse of the standard normal CDF (Acklam's rational approximation, |error| < 1.2e-9)
+double NormalQuantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double pLow = 0.02425;
+    if (p < pLow || p > 1.0 - pLow) {
+        double q = std::sqrt(-2.0 * std::log(p < pLow ? p : 1.0 - p));
+        double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                   ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        return p < pLow ? x : -x;
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+// Student t quantile with `dof` degrees of freedom (Cornish-Fisher expansion around
+// the normal quantile; within 1% of the exact value from 2 degrees of freedom up)
+double StudentTQuantile(double p, uint32_t dof) {
+    double z = NormalQuantile(p);
+    double n = dof;
+    double z3 = z * z * z;
+    double z5 = z3 * z * z;
+    double z7 = z5 * z * z;
+    double z9 = z7 * z * z;
+    return z + (z3 + z) / (4 * n) + (5 * z5 + 16 * z3 + 3 * z) / (96 * n * n) +
+           (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * n * n * n) +
+           (79 * z9 + 776 * z7 + 1482 * z5 - 1920 * z3 - 945 * z) / (92160 * n * n * n * n);
+}
+
+double RunningStat::GetHalfWidth(double confidence) const {
+    if (m_count < 2) {
+        return 0.0;
+    }
+    return StudentTQuantile(0.5 + confidence / 2, m_count - 1) * std::sqrt(GetVariance() / m_count);
+}
+
+// ---------------------------------------------------------------------------
+// Parameter sweep driver
+//
+// A sweep point is an ordered list of parameter assignments (e.g. useA2A4=1
+// hysteresis=2). Each point runs in its own forked worker process, so the
+// ns-3 singletons never leak between runs; the parent only schedules workers
+// and appends one CSV row per finished point.
+// ---------------------------------------------------------------------------
+
+typedef std::vector<std::pair<std::string, std::string>> SweepPoint;
+
+// Canonical "name=value name=value" key of a point, used to resume a sweep
+std::string SweepPointKey(const SweepPoint &point) {
+    std::string key;
+    for (auto const &assignment : point) {
+        if (!key.empty()) {
+            key += " ";
+        }
+        key += assignment.first + "=" + assignment.second;
+    }
+    return key;
+}
+
+std::vector<std::string> SplitString(const std::string &text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, separator)) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+// Expand one grid dimension: either a comma list "a,b,c" or a numeric range "start:stop:step"
+std::vector<std::string> ExpandSweepValues(const std::string &spec) {
+    std::vector<std::string> values;
+    std::vector<std::string> range = SplitString(spec, ':');
+    if (range.size() == 3) {
+        double start = std::stod(range[0]);
+        double stop = std::stod(range[1]);
+        double step = std::stod(range[2]);
+        NS_ABORT_MSG_IF(step <= 0.0, "Sweep range step must be positive: " << spec);
+        // Count steps up front so floating point accumulation cannot drop the end point
+        uint32_t steps = static_cast<uint32_t>(std::floor((stop - start) / step + 1e-9));
+        for (uint32_t i = 0; i <= steps; ++i) {
+            std::ostringstream value;
+            value << start + i * step;
+            values.push_back(value.str());
+        }
+    } else {
+        values = SplitString(spec, ',');
+    }
+    NS_ABORT_MSG_IF(values.empty(), "Empty sweep value list: " << spec);
+    return values;
+}
+
+// Grid spec "name=v1,v2;name=start:stop:step" -> cartesian product of all dimensions
+std::vector<SweepPoint> ParseSweepGrid(const std::string &spec) {
+    std::vector<SweepPoint> points(1);
+    for (auto const &dimension : SplitString(spec, ';')) {
+        size_t eq = dimension.find('=');
+        NS_ABORT_MSG_IF(eq == std::string::npos, "Sweep dimension must be name=values: " << dimension);
+        std::string name = dimension.substr(0, eq);
+        std::vector<SweepPoint> expanded;
+        for (auto const &point : points) {
+            for (auto const &value : ExpandSweepValues(dimension.substr(eq + 1))) {
+                SweepPoint next = point;
+                next.emplace_back(name, value);
+                expanded.push_back(next);
+            }
+        }
+        points = expanded;
+    }
+    return points;
+}
+
+// List file: one point per line as "name=value name=value"; blank lines and '#' comments ignored
+std::vector<SweepPoint> ParseSweepList(const std::string &fileName) {
+    std::ifstream in(fileName);
+    NS_ABORT_MSG_IF(!in, "Cannot open sweep list " << fileName);
+    std::vector<SweepPoint> points;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        SweepPoint point;
+        for (auto const &assignment : SplitString(line, ' ')) {
+            size_t eq = assignment.find('=');
+            NS_ABORT_MSG_IF(eq == std::string::npos, "Sweep list entry must be name=value: " << assignment);
+            point.emplace_back(assignment.substr(0, eq), assignment.substr(eq + 1));
+        }
+        if (!point.empty()) {
+            points.push_back(point);
+        }
+    }
+    return points;
+}
+
+// Apply a point's assignments on top of the base configuration, reusing the command line parser
+SimulationConfig ApplySweepPoint(const SimulationConfig &base, const SweepPoint &point) {
+    SimulationConfig config = base;
+    CommandLine cmd;
+    AddConfigValues(cmd, config);
+    std::vector<std::string> args = {"FYP2_SimulationCode"};
+    for (auto const &assignment : point) {
+        args.push_back("--" + assignment.first + "=" + assignment.second);
+    }
+    cmd.Parse(args);
+    return config;
+}
+
+// Keys of points already recorded as finished in an existing results table
+std::set<std::string> ReadFinishedSweepPoints(const std::string &fileName) {
+    std::set<std::string> finished;
+    std::ifstream in(fileName);
+    std::string line;
+    std::getline(in, line);  // header
+    while (std::getline(in, line)) {
+        // Rows are "<quoted point>,...,<status>"; the point is the only quoted field
+        size_t close = line.find('"', 1);
+        if (line.size() < 3 || line[0] != '"' || close == std::string::npos) {
+            continue;
+        }
+        if (line.compare(line.size() - 3, 3, ",ok") == 0) {
+            finished.insert(line.substr(1, close - 1));
+        }
+    }
+    return finished;
+}
+
+// Results table shared by sweeps and warm-start branches: one CSV row per point
+class ResultTable {
+public:
+    ResultTable(const std::string &fileName, const std::vector<SweepPoint> &points) {
+        // Every parameter named by any point gets its own column
+        for (auto const &point : points) {
+            for (auto const &assignment : point) {
+                if (std::find(m_columns.begin(), m_columns.end(), assignment.first) == m_columns.end()) {
+                    m_columns.push_back(assignment.first);
+                }
+            }
+        }
+        std::ostringstream header;
+        header << "point";
+        for (auto const &column : m_columns) {
+            header << "," << column;
+        }
+        header << ",throughputMbps,anoh,optimizationRatio,handovers,wallSeconds,events,"
+                  "pingPongRate,tooEarly,tooLate,handoverFailures,interruptionMs,peakRssKb,connectedSeconds,"
+                  "connectedWallSeconds,peakQueueDepth,status";
+
+        // Appending to a table of another grid or an older column layout would
+        // misalign every new row
+        std::string existing;
+        std::ifstream in(fileName);
+        bool writeHeader = !std::getline(in, existing);
+        NS_ABORT_MSG_IF(!writeHeader && existing != header.str(),
+                        fileName << " was written with different columns; use another output file.\n  found:    "
+                                 << existing << "\n  expected: " << header.str());
+        m_out.open(fileName, std::ios::app);
+        NS_ABORT_MSG_IF(!m_out, "Cannot open results file " << fileName);
+        if (writeHeader) {
+            m_out << header.str() << std::endl;
+        }
+        m_out.precision(10);
+    }
+
+    void Write(const SweepPoint &point, const SimulationResult &result, bool ok) {
+        m_out << "\"" << SweepPointKey(point) << "\"";
+        for (auto const &column : m_columns) {
+            m_out << ",";
+            for (auto const &assignment : point) {
+                if (assignment.first == column) {
+                    m_out << assignment.second;
+                }
+            }
+        }
+        m_out << "," << result.throughputMbps << "," << result.anoh << "," << result.optimizationRatio
+              << "," << result.handoverCount << "," << result.wallSeconds << "," << result.events
+              << "," << result.pingPongRate << "," << result.tooEarly << "," << result.tooLate
+              << "," << result.handoverFailures << "," << result.interruptionMs << "," << result.peakRssKb
+              << "," << result.connectedSeconds << "," << result.connectedWallSeconds << "," << result.peakQueueDepth
+              << "," << (ok ? "ok" : "failed") << std::endl;
+    }
+
+private:
+    std::vector<std::string> m_columns;
+    std::ofstream m_out;
+};
+
+std::string SerializeResult(const SimulationResult &result) {
+    std::ostringstream line;
+    line.precision(17);
+    line << result.throughputMbps << " " << result.anoh << " "
+         << result.optimizationRatio << " " << result.handoverCount << " "
+         << result.wallSeconds << " " << result.events << " " << result.pingPongRate << " "
+         << result.tooEarly << " " << result.tooLate << " " << result.handoverFailures << " "
+         << result.interruptionMs << " " << result.peakRssKb << " " << result.connectedSeconds << " "
+         << result.connectedWallSeconds << " " << result.peakQueueDepth << "\n";
+    return line.str();
+}
+
+bool ParseResult(const std::string &text, SimulationResult &result) {
+    std::istringstream in(text);
+    return static_cast<bool>(in >> result.throughputMbps >> result.anoh >> result.optimizationRatio >> result.handoverCount
+                                >> result.wallSeconds >> result.events >> result.pingPongRate >> result.tooEarly
+                                >> result.tooLate >> result.handoverFailures >> result.interruptionMs
+                                >> result.peakRssKb >> result.connectedSeconds >> result.connectedWallSeconds
+                                >> result.peakQueueDepth);
+}
+
+struct PoolWorker {
+    size_t task;
+    int resultFd;
+};
+
+// Run work(task) for every task in a forked worker process, at most `jobs` at
+// a time (0 = all cores). Each worker sends its result back over a pipe and
+// done(task, result, ok) is called in the parent as the worker exits. Once
+// stop() returns true, no new task starts and the running workers are killed.
+void RunWorkerPool(const std::vector<size_t> &tasks, uint32_t jobs,
+                   const std::function<SimulationResult(size_t)> &work,
+                   const std::function<void(size_t, const SimulationResult &, bool)> &done,
+                   const std::function<bool()> &stop = nullptr) {
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::deque<size_t> queue(tasks.begin(), tasks.end());
+    std::map<pid_t, PoolWorker> running;
+    while (!queue.empty() || !running.empty()) {
+        if (stop && stop()) {
+            for (auto const &worker : running) {
+                kill(worker.first, SIGKILL);
+                waitpid(worker.first, nullptr, 0);
+                close(worker.second.resultFd);
+            }
+            return;
+        }
+        // Keep at most `jobs` workers in flight
+        while (!queue.empty() && running.size() < jobs) {
+            size_t task = queue.front();
+            queue.pop_front();
+            int fds[2];
+            NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+            std::cout.flush();
+            pid_t pid = fork();
+            NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+            if (pid == 0) {
+                close(fds[0]);
+                // Keep the per-run trace logging out of the driver's console
+                if (!freopen("/dev/null", "w", stdout)) {
+                    _exit(2);
+                }
+                std::string text = SerializeResult(work(task));
+                // Shorter than PIPE_BUF, so this write is atomic and never blocks
+                ssize_t written = write(fds[1], text.data(), text.size());
+                close(fds[1]);
+                _exit(written == static_cast<ssize_t>(text.size()) ? 0 : 3);
+            }
+            close(fds[1]);
+            running[pid] = PoolWorker{task, fds[0]};
+        }
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0 || running.count(pid) == 0) {
+            continue;
+        }
+        PoolWorker worker = running[pid];
+        running.erase(pid);
+
+        std::string reply;
+        char buffer[256];
+        ssize_t n;
+        while ((n = read(worker.resultFd, buffer, sizeof(buffer))) > 0) {
+            reply.append(buffer, n);
+        }
+        close(worker.resultFd);
+
+        SimulationResult result;
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && ParseResult(reply, result);
+        done(worker.task, result, ok);
+    }
+}
+
+// Run every point of the sweep, skipping points already finished in outFile
+int RunSweep(const SimulationConfig &base, const std::vector<SweepPoint> &points,
+             const std::string &outFile, uint32_t jobs) {
+    std::set<std::string> finished = ReadFinishedSweepPoints(outFile);
+    ResultTable table(outFile, points);
+
+    std::vector<size_t> tasks;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (finished.count(SweepPointKey(points[i])) == 0) {
+            tasks.push_back(i);
+        }
+    }
+    std::cout << "Sweep: " << points.size() << " points, " << points.size() - tasks.size()
+              << " already done -> " << outFile << std::endl;
+
+    size_t done = 0;
+    RunWorkerPool(tasks, jobs,
+        [&](size_t index) {
+            SimulationConfig config = ApplySweepPoint(base, points[index]);
+            if (!config.eventLog.empty()) {
+                config.eventLog += "." + std::to_string(index);
+            }
+            if (!config.kpiFile.empty()) {
+                config.kpiFile += "." + std::to_string(index);
+            }
+            if (!config.telemetry.empty()) {
+                config.telemetry += "." + std::to_string(index);
+            }
+            if (!config.handoverStatsFile.empty()) {
+                config.handoverStatsFile += "." + std::to_string(index);
+            }
+            return RunSimulation(config);
+        },
+        [&](size_t index, const SimulationResult &result, bool ok) {
+            table.Write(points[index], result, ok);
+            ++done;
+            std::cout << "[" << done << "/" << tasks.size() << "] " << SweepPointKey(points[index])
+                      << (ok ? "" : " FAILED") << std::endl;
+        });
+    return 0;
+}
+
+// Parse "name=v,name=v;name=v,..." into one point per branch
+std::vector<SweepPoint> ParseBranches(const std::string &spec) {
+    std::vector<SweepPoint> branches;
+    for (auto const &branch : SplitString(spec, ';')) {
+        SweepPoint point;
+        for (auto const &assignment : SplitString(branch, ',')) {
+            size_t eq = assignment.find('=');
+            NS_ABORT_MSG_IF(eq == std::string::npos, "Branch entry must be name=value: " << assignment);
+            point.emplace_back(assignment.substr(0, eq), assignment.substr(eq + 1));
+        }
+        branches.push_back(point);
+    }
+    return branches;
+}
+
+// Run the warm-up once, then fork one child per branch to finish the run with
+// that branch's handover parameters. KPIs cover [branchAt, simTime] only.
+int RunBranches(const SimulationConfig &base, const std::vector<SweepPoint> &branches,
+                const std::string &outFile, uint32_t jobs, std::vector<SimulationResult> *results = nullptr) {
+    NS_ABORT_MSG_IF(base.branchAt >= base.simTime, "branchAt must be before simTime");
+    NS_ABORT_MSG_IF(base.screen, "Warm-start branching needs the full simulation, not --screen");
+    static const std::set<std::string> handoverParameters = {
+        "useA2A4", "hysteresis", "timeToTrigger", "servingCellThreshold", "neighbourCellOffset"};
+    g_handoverVariants = {MakeHandoverVariant(base)};
+    for (auto const &branch : branches) {
+        for (auto const &assignment : branch) {
+            NS_ABORT_MSG_IF(handoverParameters.count(assignment.first) == 0,
+                            "Branches can only change handover parameters, not " << assignment.first);
+        }
+        g_handoverVariants.push_back(MakeHandoverVariant(ApplySweepPoint(base, branch)));
+    }
+    // Every distinct A3 variant takes one of the 32 measurement identities a UE
+    // supports and every A2-A4 variant two (A2 and A4); leave room for ANR
+    std::set<HandoverVariantKey> variants;
+    uint32_t measIds = 0;
+    for (auto const &variant : g_handoverVariants) {
+        if (variants.insert(GetHandoverVariantKey(variant)).second) {
+            measIds += variant.useA2A4 ? 2 : 1;
+        }
+    }
+    NS_ABORT_MSG_IF(measIds > 30, "Too many distinct handover variants across branches");
+    ResultTable table(outFile, branches);
+
+    auto warmStart = std::chrono::steady_clock::now();
+    Scenario scenario;
+    BuildScenario(base, scenario);
+    Simulator::Stop(base.branchAt);
+    Simulator::Run();
+    uint64_t warmDlBytes = GetDownlinkBytes(base, scenario);
+    uint32_t warmHandovers = g_handoverCount;
+    uint64_t warmEvents = Simulator::GetEventCount();
+    std::cout << "Warm-up done at " << base.branchAt.As(Time::S) << ", forking "
+              << branches.size() << " branches -> " << outFile << std::endl;
+
+    // The recorder thread and buffered file output must not be shared with the children
+    if (g_eventRecorder) {
+        g_eventRecorder->Stop();
+    }
+    if (g_kpiCollector) {
+        g_kpiCollector->Flush();
+    }
+
+    std::vector<size_t> tasks(branches.size());
+    std::iota(tasks.begin(), tasks.end(), 0);
+    size_t done = 0;
+    RunWorkerPool(tasks, jobs,
+        [&](size_t index) {
+            auto start = std::chrono::steady_clock::now();
+            g_activeHandoverVariant = index + 1;
+            if (g_eventRecorder) {
+                g_eventRecorder.reset(new EventRecorder(base.eventLog + ".branch" + std::to_string(index),
+                                                        base.eventBufferSize));
+            }
+            if (g_kpiCollector && !base.kpiFile.empty()) {
+                g_kpiCollector->Reopen(base.kpiFile + ".branch" + std::to_string(index));
+            }
+            if (g_telemetry && !base.telemetry.empty()) {
+                g_telemetry->Open(base.telemetry + ".branch" + std::to_string(index), base.telemetryPeriod);
+            }
+            if (g_handoverAnalytics) {
+                g_handoverAnalytics->ResetCounters();
+            }
+            Simulator::Stop(base.simTime - base.branchAt);
+            Simulator::Run();
+            SimulationResult result = ComputeResult(base, GetDownlinkBytes(base, scenario) - warmDlBytes,
+                                                    g_handoverCount - warmHandovers, base.simTime - base.branchAt);
+            FinishHandoverStats(base.handoverStatsFile.empty() ? ""
+                                    : base.handoverStatsFile + ".branch" + std::to_string(index), result);
+            result.events = Simulator::GetEventCount() - warmEvents;
+            result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.peakRssKb = ReadProcKb("/proc/self/status", "VmHWM");
+            FinishStartupStats(warmStart, result);
+            TeardownScenario();
+            return result;
+        },
+        [&](size_t index, const SimulationResult &result, bool ok) {
+            table.Write(branches[index], result, ok);
+            if (results && ok) {
+                (*results)[index] = result;
+            }
+            ++done;
+            std::cout << "[" << done << "/" << branches.size() << "] " << SweepPointKey(branches[index])
+                      << (ok ? "" : " FAILED") << std::endl;
+        });
+
+    TeardownScenario();
+    return 0;
+}
+
+// Check the branching machinery: with an A3 and an A2-A4 variant that differ
+// from the base (so every UE carries their report configurations and their
+// inactive algorithms run next to the base one), the branch that keeps the base
+// handover parameters must reproduce a standalone run with the stock algorithm,
+// measured over the same [branchAt, simTime] window
+int RunBranchValidation(const SimulationConfig &base, const std::string &outFile, uint32_t jobs) {
+    NS_ABORT_MSG_IF(base.branchAt >= base.simTime, "branchAt must be before simTime");
+    NS_ABORT_MSG_IF(base.screen, "Branch validation needs the full simulation, not --screen");
+    SimulationConfig config = base;
+    config.eventLog.clear();
+    config.kpiFile.clear();
+    config.telemetry.clear();
+    config.handoverStatsFile.clear();
+
+    // Standalone run in its own process, so the branched run below starts from the same state
+    SimulationResult standalone;
+    bool standaloneOk = false;
+    RunWorkerPool({0}, 1,
+        [&](size_t) {
+            Scenario scenario;
+            BuildScenario(config, scenario);
+            Simulator::Stop(config.branchAt);
+            Simulator::Run();
+            uint64_t warmDlBytes = GetDownlinkBytes(config, scenario);
+            uint32_t warmHandovers = g_handoverCount;
+            Simulator::Stop(config.simTime - config.branchAt);
+            Simulator::Run();
+            SimulationResult result = ComputeResult(config, GetDownlinkBytes(config, scenario) - warmDlBytes,
+                                                    g_handoverCount - warmHandovers, config.simTime - config.branchAt);
+            TeardownScenario();
+            return result;
+        },
+        [&](size_t, const SimulationResult &result, bool ok) {
+            standalone = result;
+            standaloneOk = ok;
+        });
+    NS_ABORT_MSG_IF(!standaloneOk, "Standalone validation run failed");
+
+    // Branch 0 keeps the base parameters; an A3 and an A2-A4 variant with other
+    // parameters differ from it whichever algorithm the base uses
+    double otherHysteresis = config.hysteresis >= 3.0 ? config.hysteresis - 2.0 : config.hysteresis + 2.0;
+    uint16_t otherTimeToTrigger = config.timeToTrigger == 480 ? 256 : 480;
+    uint8_t otherThreshold = config.servingCellThreshold >= 32 ? config.servingCellThreshold - 2
+                                                               : config.servingCellThreshold + 2;
+    std::vector<SweepPoint> branches = {
+        {{"useA2A4", config.useA2A4 ? "1" : "0"}},
+        {{"useA2A4", "0"}, {"hysteresis", std::to_string(otherHysteresis)},
+         {"timeToTrigger", std::to_string(otherTimeToTrigger)}},
+        {{"useA2A4", "1"}, {"servingCellThreshold", std::to_string(otherThreshold)}}};
+    std::vector<SimulationResult> branched(branches.size());
+    RunBranches(config, branches, outFile, jobs, &branched);
+
+    bool match = branched[0].handoverCount == standalone.handoverCount &&
+                 std::abs(branched[0].throughputMbps - standalone.throughputMbps) <=
+                     1e-9 * std::max(1.0, std::abs(standalone.throughputMbps));
+    std::cout << "Branch validation over [" << config.branchAt.As(Time::S) << ", " << config.simTime.As(Time::S)
+              << "]:" << std::endl;
+    std::cout << "  standalone: " << standalone.throughputMbps << " Mbps, " << standalone.handoverCount
+              << " handovers" << std::endl;
+    std::cout << "  branched:   " << branched[0].throughputMbps << " Mbps, " << branched[0].handoverCount
+              << " handovers" << std::endl;
+    std::cout << "  " << (match ? "match" : "MISMATCH") << std::endl;
+    return match ? 0 : 1;
+}
+
+// Paired equivalence check of one KPI: the 90% confidence interval of the
+// per-replication difference (two one-sided tests at 5%) must lie within
+// +-margin of the TCP mean
+bool CheckEquivalence(const std::string &name, const RunningStat &reference, const RunningStat &difference,
+                      double margin) {
+    double scale = std::abs(reference.GetMean());
+    double low = (difference.GetMean() - difference.GetHalfWidth(0.90)) / scale;
+    double high = (difference.GetMean() + difference.GetHalfWidth(0.90)) / scale;
+    bool equivalent = scale > 0.0 && low >= -margin && high <= margin;
+    std::cout << "  " << name << ": saturated - tcp = " << 100.0 * difference.GetMean() / scale << "% (90% CI "
+              << 100.0 * low << "% .. " << 100.0 * high << "%) -> "
+              << (equivalent ? "equivalent" : "NOT equivalent") << " within +-" << 100.0 * margin << "%"
+              << std::endl;
+    return equivalent;
+}
+
+// Run `runs` replications of the base scenario with TCP applications and with
+// saturated bearers, then compare cost (wall time, events/s) and KPIs. Both modes
+// measure throughput at the same layer, from the RLC PDUs received on the UE DRBs.
+int RunTrafficBenchmark(const SimulationConfig &base, uint32_t runs, const std::string &outFile,
+                        uint32_t jobs, double margin) {
+    NS_ABORT_MSG_IF(runs < 2, "The traffic benchmark needs at least 2 runs");
+    NS_ABORT_MSG_IF(base.disableDl || base.disableUl, "The traffic benchmark needs both directions loaded");
+    static const std::vector<std::string> modes = {"tcp", "saturated"};
+    std::vector<SweepPoint> points;
+    for (uint32_t r = 0; r < runs; ++r) {
+        for (auto const &mode : modes) {
+            points.push_back({{"trafficMode", mode}, {"rngRun", std::to_string(base.rngRun + r)}});
+        }
+    }
+    ResultTable table(outFile, points);
+    std::cout << "Traffic benchmark: " << runs << " runs x {tcp, saturated} -> " << outFile << std::endl;
+
+    std::vector<SimulationResult> results(points.size());
+    std::vector<bool> succeeded(points.size(), false);
+    std::vector<size_t> tasks(points.size());
+    std::iota(tasks.begin(), tasks.end(), 0);
+    RunWorkerPool(tasks, jobs,
+        [&](size_t index) {
+            SimulationConfig config = ApplySweepPoint(base, points[index]);
+            config.rlcThroughput = true;
+            config.eventLog.clear();
+            config.kpiFile.clear();
+            config.telemetry.clear();
+            config.handoverStatsFile.clear();
+            return RunSimulation(config);
+        },
+        [&](size_t index, const SimulationResult &result, bool ok) {
+            table.Write(points[index], result, ok);
+            results[index] = result;
+            succeeded[index] = ok;
+            std::cout << "  " << SweepPointKey(points[index]) << ": " << result.wallSeconds << " s wall, "
+                      << result.events << " events" << (ok ? "" : " FAILED") << std::endl;
+        });
+
+    // Replications where both modes finished, paired by rngRun
+    RunningStat throughput[2], anoh[2], wall[2], eventRate[2];
+    RunningStat throughputDiff, anohDiff;
+    for (uint32_t r = 0; r < runs; ++r) {
+        if (!succeeded[2 * r] || !succeeded[2 * r + 1]) {
+            continue;
+        }
+        for (int m = 0; m < 2; ++m) {
+            const SimulationResult &result = results[2 * r + m];
+            throughput[m].Add(result.throughputMbps);
+            anoh[m].Add(result.anoh);
+            wall[m].Add(result.wallSeconds);
+            eventRate[m].Add(result.wallSeconds > 0.0 ? result.events / result.wallSeconds : 0.0);
+        }
+        throughputDiff.Add(results[2 * r + 1].throughputMbps - results[2 * r].throughputMbps);
+        anohDiff.Add(results[2 * r + 1].anoh - results[2 * r].anoh);
+    }
+    NS_ABORT_MSG_IF(throughputDiff.GetCount() < 2, "Fewer than 2 complete replication pairs");
+
+    std::cout << throughputDiff.GetCount() << " paired replications (mean +- 95% CI)" << std::endl;
+    for (int m = 0; m < 2; ++m) {
+        std::cout << "  " << modes[m] << ": throughput " << throughput[m].GetMean() << " +- "
+                  << throughput[m].GetHalfWidth(0.95) << " Mbps, ANOH " << anoh[m].GetMean() << " +- "
+                  << anoh[m].GetHalfWidth(0.95) << ", wall " << wall[m].GetMean() << " +- "
+                  << wall[m].GetHalfWidth(0.95) << " s, " << eventRate[m].GetMean() << " events/s" << std::endl;
+    }
+    std::cout << "  speedup (wall time tcp / saturated): " << wall[0].GetMean() / wall[1].GetMean() << std::endl;
+    bool equivalent = CheckEquivalence("throughput", throughput[0], throughputDiff, margin);
+    equivalent = CheckEquivalence("ANOH", anoh[0], anohDiff, margin) && equivalent;
+    return equivalent ? 0 : 1;
+}
+
+// Run `runs` replications of the base scenario with the usual attach at t = 0
+// and with the staggered geometry-based attach (attachRamp, 1 s if not set),
+// and compare start-up cost: time until every UE is connected (simulated and
+// wall-clock), peak event queue depth, total wall time and the KPIs
+int RunAttachBenchmark(const SimulationConfig &base, uint32_t runs, const std::string &outFile, uint32_t jobs) {
+    NS_ABORT_MSG_IF(runs < 2, "The attach benchmark needs at least 2 runs");
+    Time ramp = base.attachRamp.IsStrictlyPositive() ? base.attachRamp : Seconds(1);
+    static const std::vector<std::string> modes = {"at once", "staggered"};
+    std::vector<SweepPoint> points;
+    for (uint32_t r = 0; r < runs; ++r) {
+        points.push_back({{"attachRamp", "0s"}, {"rngRun", std::to_string(base.rngRun + r)}});
+        points.push_back({{"attachRamp", std::to_string(ramp.GetSeconds()) + "s"}, {"rngRun", std::to_string(base.rngRun + r)}});
+    }
+    ResultTable table(outFile, points);
+    std::cout << "Attach benchmark: " << runs << " runs x {at once, staggered over " << ramp.As(Time::S) << " in "
+              << base.attachBatches << " batches} -> " << outFile << std::endl;
+
+    std::vector<SimulationResult> results(points.size());
+    std::vector<bool> succeeded(points.size(), false);
+    std::vector<size_t> tasks(points.size());
+    std::iota(tasks.begin(), tasks.end(), 0);
+    RunWorkerPool(tasks, jobs,
+        [&](size_t index) {
+            SimulationConfig config = ApplySweepPoint(base, points[index]);
+            config.queueStats = true;
+            config.eventLog.clear();
+            config.kpiFile.clear();
+            config.telemetry.clear();
+            config.handoverStatsFile.clear();
+            return RunSimulation(config);
+        },
+        [&](size_t index, const SimulationResult &result, bool ok) {
+            table.Write(points[index], result, ok);
+            results[index] = result;
+            succeeded[index] = ok;
+            std::cout << "  " << SweepPointKey(points[index]) << ": all connected at " << result.connectedSeconds
+                      << " s (" << result.connectedWallSeconds << " s wall), peak queue " << result.peakQueueDepth
+                      << (ok ? "" : " FAILED") << std::endl;
+        });
+
+    // Replications where both modes finished with every UE connected, paired by rngRun
+    RunningStat connected[2], connectedWall[2], peakQueue[2], wall[2], throughput[2], anoh[2];
+    uint32_t incomplete = 0;
+    for (uint32_t r = 0; r < runs; ++r) {
+        if (!succeeded[2 * r] || !succeeded[2 * r + 1]) {
+            continue;
+        }
+        if (results[2 * r].connectedSeconds < 0.0 || results[2 * r + 1].connectedSeconds < 0.0) {
+            ++incomplete;
+            continue;
+        }
+        for (int m = 0; m < 2; ++m) {
+            const SimulationResult &result = results[2 * r + m];
+            connected[m].Add(result.connectedSeconds);
+            connectedWall[m].Add(result.connectedWallSeconds);
+            peakQueue[m].Add(result.peakQueueDepth);
+            wall[m].Add(result.wallSeconds);
+            throughput[m].Add(result.throughputMbps);
+            anoh[m].Add(result.anoh);
+        }
+    }
+    if (incomplete > 0) {
+        std::cout << incomplete << " replication(s) left some UE unconnected and were skipped" << std::endl;
+    }
+    NS_ABORT_MSG_IF(wall[0].GetCount() < 2, "Fewer than 2 complete replication pairs");
+
+    std::cout << wall[0].GetCount() << " paired replications (mean +- 95% CI)" << std::endl;
+    for (int m = 0; m < 2; ++m) {
+        std::cout << "  " << modes[m] << ": all connected at " << connected[m].GetMean() << " +- "
+                  << connected[m].GetHalfWidth(0.95) << " s (" << connectedWall[m].GetMean() << " +- "
+                  << connectedWall[m].GetHalfWidth(0.95) << " s wall), peak queue " << peakQueue[m].GetMean()
+                  << " +- " << peakQueue[m].GetHalfWidth(0.95) << " events, total wall " << wall[m].GetMean()
+                  << " s, throughput " << throughput[m].GetMean() << " Mbps, ANOH " << anoh[m].GetMean() << std::endl;
+    }
+    std::cout << "  wall time to all connected, at once / staggered: "
+              << connectedWall[0].GetMean() / connectedWall[1].GetMean() << std::endl;
+    std::cout << "  peak queue depth, at once / staggered: " << peakQueue[0].GetMean() / peakQueue[1].GetMean()
+              << std::endl;
+    return 0;
+}
+
+// Stopping rule and budget of a replication run
+struct ReplicationSettings {
+    uint32_t minRuns = 5;
+    uint32_t maxRuns = 0;      // 0 = replication mode off
+    double precision = 0.05;   // target confidence interval half width, relative to the mean
+    double confidence = 0.95;
+    bool pairedA2A4 = false;   // compare A3-RSRP and A2-A4-RSRQ on common random numbers
+};
+
+// Confidence interval half width relative to `scale` (infinite until it is known)
+double RelativeHalfWidth(const RunningStat &stat, double scale, double confidence) {
+    if (stat.GetCount() < 2) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double halfWidth = stat.GetHalfWidth(confidence);
+    if (halfWidth == 0.0) {
+        return 0.0;
+    }
+    return scale != 0.0 ? halfWidth / std::abs(scale) : std::numeric_limits<double>::infinity();
+}
+
+void PrintInterval(const std::string &name, const RunningStat &stat, double confidence) {
+    std::cout << "  " << name << ": " << stat.GetMean() << " +- " << stat.GetHalfWidth(confidence) << std::endl;
+}
+
+// Run independent rngRun replications (rngRun, rngRun + 1, ...) in parallel and
+// stop once the confidence intervals of throughput and ANOH reach the target
+// relative precision. With pairedA2A4 every replication runs both algorithms on
+// the same UE drop and headings, and the rule applies to their difference.
+// Results are folded in rngRun order, so the stopping point does not depend on
+// which worker happens to finish first.
+int RunReplications(const SimulationConfig &base, const ReplicationSettings &settings,
+                    const std::string &outFile, uint32_t jobs) {
+    NS_ABORT_MSG_IF(settings.minRuns < 2 || settings.maxRuns < settings.minRuns,
+                    "Replications need 2 <= minReplications <= replicate");
+    uint32_t arms = settings.pairedA2A4 ? 2 : 1;
+    std::vector<SweepPoint> points;
+    for (uint32_t r = 0; r < settings.maxRuns; ++r) {
+        std::string run = std::to_string(base.rngRun + r);
+        if (settings.pairedA2A4) {
+            points.push_back({{"useA2A4", "0"}, {"rngRun", run}});
+            points.push_back({{"useA2A4", "1"}, {"rngRun", run}});
+        } else {
+            points.push_back({{"rngRun", run}});
+        }
+    }
+    ResultTable table(outFile, points);
+    std::cout << "Replications: " << settings.minRuns << ".." << settings.maxRuns << " runs"
+              << (settings.pairedA2A4 ? " of A3-RSRP vs A2-A4-RSRQ" : "") << ", target +-"
+              << 100.0 * settings.precision << "% at " << 100.0 * settings.confidence << "% confidence -> "
+              << outFile << std::endl;
+
+    enum TaskState { PENDING, SUCCEEDED, FAILED };
+    std::vector<SimulationResult> results(points.size());
+    std::vector<TaskState> states(points.size(), PENDING);
+    RunningStat throughput[2], anoh[2], ratio[2];
+    RunningStat throughputDiff, anohDiff;
+    uint32_t folded = 0;
+    bool converged = false;
+
+    auto precisionReached = [&]() {
+        if (settings.pairedA2A4) {
+            return RelativeHalfWidth(throughputDiff, throughput[0].GetMean(), settings.confidence) <= settings.precision &&
+                   RelativeHalfWidth(anohDiff, anoh[0].GetMean(), settings.confidence) <= settings.precision;
+        }
+        return RelativeHalfWidth(throughput[0], throughput[0].GetMean(), settings.confidence) <= settings.precision &&
+               RelativeHalfWidth(anoh[0], anoh[0].GetMean(), settings.confidence) <= settings.precision;
+    };
+
+    // Fold every replication whose runs have all finished, in rngRun order
+    auto fold = [&]() {
+        while (!converged && folded < settings.maxRuns) {
+            bool complete = true;
+            bool failed = false;
+            for (uint32_t a = 0; a < arms; ++a) {
+                complete = complete && states[folded * arms + a] != PENDING;
+                failed = failed || states[folded * arms + a] == FAILED;
+            }
+            if (!complete) {
+                return;
+            }
+            if (!failed) {
+                for (uint32_t a = 0; a < arms; ++a) {
+                    const SimulationResult &result = results[folded * arms + a];
+                    throughput[a].Add(result.throughputMbps);
+                    anoh[a].Add(result.anoh);
+                    ratio[a].Add(result.optimizationRatio);
+                }
+                if (settings.pairedA2A4) {
+                    throughputDiff.Add(results[folded * arms + 1].throughputMbps - results[folded * arms].throughputMbps);
+                    anohDiff.Add(results[folded * arms + 1].anoh - results[folded * arms].anoh);
+                }
+            }
+            ++folded;
+            const RunningStat &t = settings.pairedA2A4 ? throughputDiff : throughput[0];
+            const RunningStat &h = settings.pairedA2A4 ? anohDiff : anoh[0];
+            std::cout << "[" << folded << "] " << (settings.pairedA2A4 ? "A2A4 - A3: " : "")
+                      << "throughput " << t.GetMean() << " +- " << t.GetHalfWidth(settings.confidence) << " Mbps ("
+                      << 100.0 * RelativeHalfWidth(t, throughput[0].GetMean(), settings.confidence) << "%), ANOH "
+                      << h.GetMean() << " +- " << h.GetHalfWidth(settings.confidence) << " ("
+                      << 100.0 * RelativeHalfWidth(h, anoh[0].GetMean(), settings.confidence) << "%)"
+                      << (failed ? " FAILED" : "") << std::endl;
+            converged = throughput[0].GetCount() >= settings.minRuns && precisionReached();
+        }
+    };
+
+    std::vector<size_t> tasks(points.size());
+    std::iota(tasks.begin(), tasks.end(), 0);
+    RunWorkerPool(tasks, jobs,
+        [&](size_t index) {
+            SimulationConfig config = ApplySweepPoint(base, points[index]);
+            if (!config.eventLog.empty()) {
+                config.eventLog += "." + std::to_string(index);
+            }
+            if (!config.kpiFile.empty()) {
+                config.kpiFile += "." + std::to_string(index);
+            }
+            if (!config.telemetry.empty()) {
+                config.telemetry += "." + std::to_string(index);
+            }
+            if (!config.handoverStatsFile.empty()) {
+                config.handoverStatsFile += "." + std::to_string(index);
+            }
+            return RunSimulation(config);
+        },
+        [&](size_t index, const SimulationResult &result, bool ok) {
+            table.Write(points[index], result, ok);
+            results[index] = result;
+            states[index] = ok ? SUCCEEDED : FAILED;
+            fold();
+        },
+        [&]() { return converged; });
+
+    std::cout << (converged ? "Converged" : "Target precision not reached") << " after " << folded << " of "
+              << settings.maxRuns << " replications (" << throughput[0].GetCount() << " successful, mean +- "
+              << 100.0 * settings.confidence << "% CI)" << std::endl;
+    for (uint32_t a = 0; a < arms; ++a) {
+        if (settings.pairedA2A4) {
+            std::cout << (a == 0 ? "A3-RSRP" : "A2-A4-RSRQ") << std::endl;
+        }
+        PrintInterval("Total Downlink Throughput (Mbps)", throughput[a], settings.confidence);
+        PrintInterval("ANOH", anoh[a], settings.confidence);
+        PrintInterval("Optimization Ratio", ratio[a], settings.confidence);
+    }
+    if (settings.pairedA2A4) {
+        std::cout << "A2-A4-RSRQ - A3-RSRP (paired)" << std::endl;
+        PrintInterval("Total Downlink Throughput (Mbps)", throughputDiff, settings.confidence);
+        PrintInterval("ANOH", anohDiff, settings.confidence);
+    }
+    return converged ? 0 : 1;
+}
+
+// Pearson correlation of two equally long samples (0 if either is constant)
+double PearsonCorrelation(const std::vector<double> &a, const std::vector<double> &b) {
+    RunningStat sa, sb;
+    for (size_t i = 0; i < a.size(); ++i) {
+        sa.Add(a[i]);
+        sb.Add(b[i]);
+    }
+    double covariance = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        covariance += (a[i] - sa.GetMean()) * (b[i] - sb.GetMean());
+    }
+    double scale = std::sqrt(sa.GetVariance() * sb.GetVariance()) * (a.size() - 1);
+    return scale > 0.0 ? covariance / scale : 0.0;
+}
+
+// Ranks starting at 1, ties get their average rank
+std::vector<double> Ranks(const std::vector<double> &values) {
+    std::vector<size_t> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t i, size_t j) { return values[i] < values[j]; });
+    std::vector<double> ranks(values.size());
+    for (size_t i = 0; i < order.size();) {
+        size_t j = i;
+        while (j + 1 < order.size() && values[order[j + 1]] == values[order[i]]) {
+            ++j;
+        }
+        for (size_t k = i; k <= j; ++k) {
+            ranks[order[k]] = (i + j) / 2.0 + 1;
+        }
+        i = j + 1;
+    }
+    return ranks;
+}
+
+void PrintAgreement(const std::string &name, const std::vector<double> &full, const std::vector<double> &screen) {
+    RunningStat error;
+    for (size_t i = 0; i < full.size(); ++i) {
+        if (full[i] != 0.0) {
+            error.Add(std::abs(screen[i] / full[i] - 1));
+        }
+    }
+    std::cout << "  " << name << ": mean |screen / full - 1| = " << error.GetMean();
+    if (full.size() >= 3) {
+        std::cout << ", Pearson r = " << PearsonCorrelation(full, screen)
+                  << ", Spearman rho = " << PearsonCorrelation(Ranks(full), Ranks(screen));
+    }
+    std::cout << std::endl;
+}
+
+// Run every point (the --sweep grid or list, or just the base configuration)
+// over `runs` replications both screened and with the full simulation, and
+// report how well the screening KPIs track the full ones. The rank
+// correlation across points is what matters for pruning a grid.
+int RunScreeningValidation(const SimulationConfig &base, std::vector<SweepPoint> points, uint32_t runs,
+                           const std::string &outFile, uint32_t jobs) {
+    if (points.empty()) {
+        points.push_back(SweepPoint());
+    }
+    std::vector<SweepPoint> tasksPoints;
+    for (auto const &point : points) {
+        for (uint32_t r = 0; r < runs; ++r) {
+            for (const char *screen : {"0", "1"}) {
+                SweepPoint task = point;
+                task.emplace_back("rngRun", std::to_string(base.rngRun + r));
+                task.emplace_back("screen", screen);
+                tasksPoints.push_back(task);
+            }
+        }
+    }
+    ResultTable table(outFile, tasksPoints);
+    std::cout << "Screening validation: " << points.size() << " points x " << runs << " runs -> " << outFile
+              << std::endl;
+
+    std::vector<SimulationResult> results(tasksPoints.size());
+    std::vector<bool> succeeded(tasksPoints.size(), false);
+    std::vector<size_t> tasks(tasksPoints.size());
+    std::iota(tasks.begin(), tasks.end(), 0);
+    RunWorkerPool(tasks, jobs,
+        [&](size_t index) {
+            SimulationConfig config = ApplySweepPoint(base, tasksPoints[index]);
+            config.handoverStats = true;  // the full runs' ping-pong rate is compared below
+            config.eventLog.clear();
+            config.kpiFile.clear();
+            config.telemetry.clear();
+            config.handoverStatsFile.clear();
+            return RunSimulation(config);
+        },
+        [&](size_t index, const SimulationResult &result, bool ok) {
+            table.Write(tasksPoints[index], result, ok);
+            results[index] = result;
+            succeeded[index] = ok;
+        });
+
+    // Per point means over the replications where both modes finished
+    std::vector<double> fullAnoh, screenAnoh, fullPingPong, screenPingPong;
+    double fullWall = 0.0, screenWall = 0.0;
+    std::cout << "point: full ANOH / screen ANOH, full / screen ping-pong rate" << std::endl;
+    for (size_t p = 0; p < points.size(); ++p) {
+        RunningStat anoh[2], pingPong[2];
+        for (uint32_t r = 0; r < runs; ++r) {
+            size_t index = (p * runs + r) * 2;
+            if (!succeeded[index] || !succeeded[index + 1]) {
+                continue;
+            }
+            for (int m = 0; m < 2; ++m) {
+                anoh[m].Add(results[index + m].anoh);
+                pingPong[m].Add(results[index + m].pingPongRate);
+            }
+            fullWall += results[index].wallSeconds;
+            screenWall += results[index + 1].wallSeconds;
+        }
+        if (anoh[0].GetCount() == 0) {
+            std::cout << "  " << SweepPointKey(points[p]) << ": FAILED" << std::endl;
+            continue;
+        }
+        fullAnoh.push_back(anoh[0].GetMean());
+        screenAnoh.push_back(anoh[1].GetMean());
+        fullPingPong.push_back(pingPong[0].GetMean());
+        screenPingPong.push_back(pingPong[1].GetMean());
+        std::cout << "  " << (points[p].empty() ? "base" : SweepPointKey(points[p])) << ": " << anoh[0].GetMean()
+                  << " / " << anoh[1].GetMean() << ", " << pingPong[0].GetMean() << " / " << pingPong[1].GetMean()
+                  << std::endl;
+    }
+    NS_ABORT_MSG_IF(fullAnoh.empty(), "No point finished in both modes");
+    std::cout << "Agreement over " << fullAnoh.size() << " points:" << std::endl;
+    PrintAgreement("ANOH", fullAnoh, screenAnoh);
+    PrintAgreement("ping-pong rate", fullPingPong, screenPingPong);
+    std::cout << "  wall time: full " << fullWall << " s, screening " << screenWall << " s (x"
+              << (screenWall > 0.0 ? fullWall / screenWall : 0.0) << ")" << std::endl;
+    return 0;
+}
+
+// Load the text trace and the mapped binary trace in `copies` concurrent
+// processes each and compare startup time and memory. Every copy holds its
+// trace until all copies have loaded, so PSS shows what is actually shared.
+int RunFadingLoadBenchmark(const SimulationConfig &config, const std::string &binaryFile, uint32_t copies) {
+    if (copies == 0) {
+        copies = std::max(1u, std::thread::hardware_concurrency());
+    }
+    NS_ABORT_MSG_IF(!IsMappedFadingTrace(binaryFile), binaryFile << " is not a binary fading trace");
+    std::cout << "Fading trace load, " << copies << " concurrent copies (per-process means)" << std::endl;
+    for (bool mapped : {false, true}) {
+        int go[2];
+        NS_ABORT_MSG_IF(pipe(go) != 0, "pipe() failed");
+        std::vector<int> resultFds;
+        std::vector<pid_t> pids;
+        std::cout.flush();
+        for (uint32_t c = 0; c < copies; ++c) {
+            int fds[2];
+            NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+            pid_t pid = fork();
+            NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+            if (pid == 0) {
+                close(go[1]);
+                close(fds[0]);
+                auto start = std::chrono::steady_clock::now();
+                Ptr<Object> model;
+                if (mapped) {
+                    Ptr<MappedTraceFadingLossModel> mappedModel = CreateObject<MappedTraceFadingLossModel>();
+                    mappedModel->SetAttribute("TraceFilename", StringValue(binaryFile));
+                    mappedModel->SetAttribute("SamplesNum", UintegerValue(config.fadingSamples));
+                    mappedModel->Initialize();
+                    model = mappedModel;
+                } else {
+                    model = CreateObject<TraceFadingLossModel>();
+                    model->SetAttribute("TraceFilename", StringValue(config.fadingTrace));
+                    model->SetAttribute("SamplesNum", UintegerValue(config.fadingSamples));
+                    model->Initialize();
+                }
+                double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                // A run reads the whole trace over time; fault it all in before measuring
+                if (mapped) {
+                    DynamicCast<MappedTraceFadingLossModel>(model)->Touch();
+                }
+                char byte = 0;
+                ssize_t ready = write(fds[1], &byte, 1);
+                while (read(go[0], &byte, 1) > 0) {
+                }
+                std::ostringstream line;
+                line << loadSeconds << " " << ReadProcKb("/proc/self/status", "RssAnon") << " "
+                     << ReadProcKb("/proc/self/status", "RssFile") << " "
+                     << ReadProcKb("/proc/self/smaps_rollup", "Pss") << "\n";
+                std::string text = line.str();
+                ssize_t written = write(fds[1], text.data(), text.size());
+                _exit(ready == 1 && written == static_cast<ssize_t>(text.size()) ? 0 : 3);
+            }
+            close(fds[1]);
+            resultFds.push_back(fds[0]);
+            pids.push_back(pid);
+        }
+        close(go[0]);
+        // Release the copies only once all of them hold the trace
+        for (int fd : resultFds) {
+            char byte;
+            NS_ABORT_MSG_IF(read(fd, &byte, 1) != 1, "A loader process failed");
+        }
+        close(go[1]);
+
+        RunningStat loadSeconds, rssAnon, rssFile, pss;
+        for (size_t c = 0; c < resultFds.size(); ++c) {
+            std::string reply;
+            char buffer[256];
+            ssize_t n;
+            while ((n = read(resultFds[c], buffer, sizeof(buffer))) > 0) {
+                reply.append(buffer, n);
+            }
+            close(resultFds[c]);
+            int status = 0;
+            waitpid(pids[c], &status, 0);
+            std::istringstream in(reply);
+            double seconds;
+            uint64_t anon, file, proportional;
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && in >> seconds >> anon >> file >> proportional) {
+                loadSeconds.Add(seconds);
+                rssAnon.Add(anon);
+                rssFile.Add(file);
+                pss.Add(proportional);
+            }
+        }
+        std::cout << "  " << (mapped ? "mapped" : "text  ") << " (" << (mapped ? binaryFile : config.fadingTrace)
+                  << "): load " << loadSeconds.GetMean() << " s, RSS anon " << rssAnon.GetMean() << " kB, RSS file "
+                  << rssFile.GetMean() << " kB, PSS " << pss.GetMean() << " kB, total PSS "
+                  << pss.GetMean() * pss.GetCount() / 1024 << " MB" << std::endl;
+    }
+    return 0;
+}
+
+// Run the scenario once with the text trace and once with the converted binary
+// trace; both must give exactly the same KPIs. Keep simTime short.
+int RunFadingTraceCheck(const SimulationConfig &base, const std::string &binaryFile) {
+    NS_ABORT_MSG_IF(IsMappedFadingTrace(base.fadingTrace), "--fadingTrace must be the text trace for --fadingCheck");
+    NS_ABORT_MSG_IF(!IsMappedFadingTrace(binaryFile), binaryFile << " is not a binary fading trace");
+    const std::vector<std::string> traces = {base.fadingTrace, binaryFile};
+    std::vector<SimulationResult> results(traces.size());
+    std::vector<bool> succeeded(traces.size(), false);
+    RunWorkerPool({0, 1}, 1,
+        [&](size_t index) {
+            SimulationConfig config = base;
+            config.enableFading = true;
+            config.fadingTrace = traces[index];
+            config.eventLog.clear();
+            config.kpiFile.clear();
+            config.telemetry.clear();
+            config.handoverStatsFile.clear();
+            return RunSimulation(config);
+        },
+        [&](size_t index, const SimulationResult &result, bool ok) {
+            results[index] = result;
+            succeeded[index] = ok;
+            std::cout << "  " << traces[index] << ": " << result.throughputMbps << " Mbps, " << result.handoverCount
+                      << " handovers" << (ok ? "" : " FAILED") << std::endl;
+        });
+    bool match = succeeded[0] && succeeded[1] && results[0].throughputMbps == results[1].throughputMbps &&
+                 results[0].handoverCount == results[1].handoverCount;
+    std::cout << "Fading trace check: " << (match ? "identical" : "MISMATCH") << std::endl;
+    return match ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Scaling benchmark
+//
+// A fixed matrix of scenarios, each run --scalingRepeats times with rngRun 1
+// and event logging off, one after the other by default so the timings do
+// not compete for cores. The repeats are interleaved over the whole matrix,
+// and each row holds the median wall time and peak RSS of its scenario, so a
+// single noisy run (frequency scaling, a cold page cache) does not show up as
+// a regression. Parameters given on the command line (e.g. fadingTrace,
+// trafficMode) apply to every scenario. Rows are
+//   scenario,simTime,wallSeconds,simSecondsPerWallSecond,events,eventsPerSecond,peakRssKb,handovers,status
+// and a stored table can serve as the baseline for a later run.
+// ---------------------------------------------------------------------------
+
+struct ScalingScenario {
+    const char *name;
+    SweepPoint point;
+};
+
+static const std::vector<ScalingScenario> kScalingScenarios = {
+    {"ues41",     {{"numberOfUes", "41"},   {"simTime", "10"}}},
+    {"ues100",    {{"numberOfUes", "100"},  {"simTime", "10"}}},
+    {"ues250",    {{"numberOfUes", "250"},  {"simTime", "10"}}},
+    {"ues500",    {{"numberOfUes", "500"},  {"simTime", "10"}}},
+    {"ues1000",   {{"numberOfUes", "1000"}, {"simTime", "10"}}},
+    {"cells57",   {{"numberOfUes", "100"},  {"simTime", "10"}, {"siteTiers", "2"}}},
+    {"cells111",  {{"numberOfUes", "100"},  {"simTime", "10"}, {"siteTiers", "3"}}},
+    {"simTime5",  {{"numberOfUes", "41"},   {"simTime", "5"}}},
+    {"simTime25", {{"numberOfUes", "41"},   {"simTime", "25"}}},
+    {"simTime50", {{"numberOfUes", "41"},   {"simTime", "50"}}},
+    {"fading",    {{"numberOfUes", "41"},   {"simTime", "10"}, {"enableFading", "1"}}},
+    {"dlOnly",    {{"numberOfUes", "41"},   {"simTime", "10"}, {"disableUl", "1"}}},
+};
+
+struct ScalingRow {
+    double wallSeconds = 0.0;
+    uint64_t peakRssKb = 0;
+    bool ok = false;
+};
+
+// Rows of a scaling benchmark table, by scenario name
+std::map<std::string, ScalingRow> ReadScalingTable(const std::string &fileName) {
+    std::map<std::string, ScalingRow> rows;
+    std::ifstream in(fileName);
+    NS_ABORT_MSG_IF(!in, "Cannot open benchmark table " << fileName);
+    std::string line;
+    std::getline(in, line);  // header
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields = SplitString(line, ',');
+        if (fields.size() != 9) {
+            continue;
+        }
+        ScalingRow &row = rows[fields[0]];
+        row.wallSeconds = std::atof(fields[2].c_str());
+        row.peakRssKb = std::strtoull(fields[6].c_str(), nullptr, 10);
+        row.ok = fields[8] == "ok";
+    }
+    return rows;
+}
+
+// Flag every scenario whose wall time or peak RSS grew by more than `threshold`
+// (relative) over the baseline; returns the number of regressions
+uint32_t CompareScalingTables(const std::string &fileName, const std::string &baselineFile, double threshold) {
+    std::map<std::string, ScalingRow> current = ReadScalingTable(fileName);
+    std::map<std::string, ScalingRow> baseline = ReadScalingTable(baselineFile);
+    uint32_t regressions = 0;
+    std::cout << "Compared with " << baselineFile << " (threshold " << 100.0 * threshold << "%)" << std::endl;
+    for (auto const &scenario : kScalingScenarios) {
+        auto now = current.find(scenario.name);
+        auto before = baseline.find(scenario.name);
+        if (now == current.end() || before == baseline.end() || !now->second.ok || !before->second.ok) {
+            std::cout << "  " << scenario.name << ": not comparable" << std::endl;
+            continue;
+        }
+        double wallRatio = now->second.wallSeconds / before->second.wallSeconds;
+        double rssRatio = double(now->second.peakRssKb) / before->second.peakRssKb;
+        bool regression = wallRatio > 1 + threshold || rssRatio > 1 + threshold;
+        regressions += regression ? 1 : 0;
+        std::cout << "  " << scenario.name << ": wall x" << wallRatio << ", peak RSS x" << rssRatio
+                  << (regression ? "  REGRESSION" : (wallRatio < 1 - threshold ? "  faster" : "")) << std::endl;
+    }
+    std::cout << regressions << " regression(s)" << std::endl;
+    return regressions;
+}
+
+// Median of a non-empty sample
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+int RunScalingBenchmark(const SimulationConfig &base, const std::string &outFile, const std::string &baselineFile,
+                        double threshold, uint32_t jobs, uint32_t repeats) {
+    NS_ABORT_MSG_IF(repeats == 0, "scalingRepeats must be at least 1");
+    SimulationConfig fixed = base;
+    fixed.rngRun = 1;
+    fixed.verbose = false;
+    fixed.eventLog.clear();
+    fixed.kpiFile.clear();
+    fixed.telemetry.clear();
+    fixed.handoverStatsFile.clear();
+
+    std::ofstream out(outFile);
+    NS_ABORT_MSG_IF(!out, "Cannot open benchmark table " << outFile);
+    out << "scenario,simTime,wallSeconds,simSecondsPerWallSecond,events,eventsPerSecond,peakRssKb,handovers,status"
+        << std::endl;
+    out.precision(10);
+    std::cout << "Scaling benchmark: " << kScalingScenarios.size() << " scenarios x " << repeats << " repeats -> "
+              << outFile << std::endl;
+
+    // Task t runs scenario t % size in repeat t / size
+    const size_t numScenarios = kScalingScenarios.size();
+    std::vector<std::vector<SimulationResult>> results(numScenarios);
+    std::vector<bool> succeeded(numScenarios, true);
+    std::vector<size_t> tasks(numScenarios * repeats);
+    std::iota(tasks.begin(), tasks.end(), 0);
+    RunWorkerPool(tasks, jobs,
+        [&](size_t task) {
+            return RunSimulation(ApplySweepPoint(fixed, kScalingScenarios[task % numScenarios].point));
+        },
+        [&](size_t task, const SimulationResult &result, bool ok) {
+            size_t index = task % numScenarios;
+            if (ok) {
+                results[index].push_back(result);
+            } else {
+                succeeded[index] = false;
+            }
+            std::cout << "  " << kScalingScenarios[index].name << " #" << task / numScenarios + 1 << ": "
+                      << result.wallSeconds << " s wall, " << result.peakRssKb / 1024 << " MB peak"
+                      << (ok ? "" : " FAILED") << std::endl;
+        });
+
+    std::cout << "Medians over " << repeats << " repeats:" << std::endl;
+    for (size_t index = 0; index < numScenarios; ++index) {
+        double simSeconds = ApplySweepPoint(fixed, kScalingScenarios[index].point).simTime.GetSeconds();
+        bool ok = succeeded[index] && !results[index].empty();
+        std::vector<double> walls, rss;
+        for (auto const &result : results[index]) {
+            walls.push_back(result.wallSeconds);
+            rss.push_back(result.peakRssKb);
+        }
+        double wallSeconds = ok ? Median(walls) : 0.0;
+        uint64_t peakRssKb = ok ? static_cast<uint64_t>(Median(rss)) : 0;
+        uint64_t events = ok ? results[index].front().events : 0;
+        uint32_t handovers = ok ? results[index].front().handoverCount : 0;
+        double wall = wallSeconds > 0.0 ? wallSeconds : 1.0;
+        out << kScalingScenarios[index].name << "," << simSeconds << "," << wallSeconds << "," << simSeconds / wall
+            << "," << events << "," << events / wall << "," << peakRssKb << "," << handovers << ","
+            << (ok ? "ok" : "failed") << std::endl;
+        std::cout << "  " << kScalingScenarios[index].name << ": " << wallSeconds << " s wall, " << simSeconds / wall
+                  << " sim-s/s, " << events / wall << " events/s, " << peakRssKb / 1024 << " MB peak"
+                  << (ok ? "" : " FAILED") << std::endl;
+    }
+    out.close();
+
+    if (baselineFile.empty()) {
+        return 0;
+    }
+    return CompareScalingTables(outFile, baselineFile, threshold) > 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    SimulationConfig config;
+    std::string sweep;
+    std::string sweepList;
+    std::string sweepOut = "sweep-results.csv";
+    uint32_t sweepJobs = 0;
+    std::string decodeEvents;
+    std::string decodeKpi;
+    std::string branchSpec;
+    std::string branchOut = "branch-results.csv";
+    bool validateBranches = false;
+    uint32_t trafficBenchmark = 0;
+    std::string benchmarkOut = "traffic-benchmark.csv";
+    double equivalenceMargin = 0.05;
+    uint32_t attachBenchmark = 0;
+    std::string attachBenchmarkOut = "attach-benchmark.csv";
+    std::string convertFadingTrace;
+    std::string convertMobilityTrace;
+    std::string fadingBenchmark;
+    std::string fadingCheck;
+    ReplicationSettings replication;
+    std::string replicationOut = "replications.csv";
+    uint32_t validateScreening = 0;
+    std::string validationOut = "screening-validation.csv";
+    bool scalingBenchmark = false;
+    std::string scalingOut = "scaling-benchmark.csv";
+    std::string scalingBaseline;
+    std::string scalingCompare;
+    double regressionThreshold = 0.10;
+    uint32_t scalingJobs = 1;
+    uint32_t scalingRepeats = 3;
+    std::string telemetryView;
+    uint32_t telemetryTop = 10;
+
+    // Parse command-line arguments
+    CommandLine cmd;
+    AddConfigValues(cmd, config);
+    cmd.AddValue("sweep", "Parameter grid to sweep, e.g. \"useA2A4=0,1;hysteresis=1:3:0.5\"", sweep);
+    cmd.AddValue("sweepList", "File with one sweep point per line (name=value ...)", sweepList);
+    cmd.AddValue("sweepOut", "Sweep results table (CSV, appended; finished points are skipped)", sweepOut);
+    cmd.AddValue("sweepJobs", "Concurrent sweep workers (0 = all cores)", sweepJobs);
+    cmd.AddValue("decodeEvents", "Print a binary event log as text and exit", decodeEvents);
+    cmd.AddValue("decodeKpi", "Print a KPI file as CSV and exit", decodeKpi);
+    cmd.AddValue("branches", "Handover variants forked after --branchAt, e.g. \"hysteresis=1,timeToTrigger=256;useA2A4=1\"", branchSpec);
+    cmd.AddValue("branchOut", "Warm-start branch results table (CSV)", branchOut);
+    cmd.AddValue("validateBranches", "Compare a branch with the base parameters against a standalone run", validateBranches);
+    cmd.AddValue("trafficBenchmark", "Compare tcp and saturated traffic over this many replications", trafficBenchmark);
+    cmd.AddValue("benchmarkOut", "Traffic benchmark results table (CSV)", benchmarkOut);
+    cmd.AddValue("equivalenceMargin", "Relative KPI difference accepted as equivalent by the benchmark", equivalenceMargin);
+    cmd.AddValue("attachBenchmark", "Compare attaching at once and staggered over this many replications", attachBenchmark);
+    cmd.AddValue("attachBenchmarkOut", "Attach benchmark results table (CSV)", attachBenchmarkOut);
+    cmd.AddValue("replicate", "Run up to this many rngRun replications until the KPIs converge", replication.maxRuns);
+    cmd.AddValue("minReplications", "Replications run before the stopping rule applies", replication.minRuns);
+    cmd.AddValue("targetPrecision", "Stop when every KPI confidence interval is within this fraction of its mean", replication.precision);
+    cmd.AddValue("confidence", "Confidence level of the replication intervals", replication.confidence);
+    cmd.AddValue("pairedA2A4", "Replicate A3-RSRP and A2-A4-RSRQ on common random numbers", replication.pairedA2A4);
+    cmd.AddValue("replicationOut", "Replication results table (CSV)", replicationOut);
+    cmd.AddValue("validateScreening", "Compare --screen with full runs over this many replications of each sweep point", validateScreening);
+    cmd.AddValue("validationOut", "Screening validation results table (CSV)", validationOut);
+    cmd.AddValue("scalingBenchmark", "Run the fixed scaling benchmark matrix", scalingBenchmark);
+    cmd.AddValue("scalingOut", "Scaling benchmark results table (CSV)", scalingOut);
+    cmd.AddValue("scalingBaseline", "Earlier scaling benchmark table to flag regressions against", scalingBaseline);
+    cmd.AddValue("scalingCompare", "Compare this scaling benchmark table with --scalingBaseline and exit", scalingCompare);
+    cmd.AddValue("regressionThreshold", "Relative wall time / peak RSS growth reported as a regression", regressionThreshold);
+    cmd.AddValue("scalingJobs", "Concurrent scaling benchmark runs (timings are only comparable at 1)", scalingJobs);
+    cmd.AddValue("scalingRepeats", "Runs per scaling benchmark scenario; the table keeps the medians", scalingRepeats);
+    cmd.AddValue("telemetryView", "Show the live telemetry of a run (its --telemetry file or unix:<socket path>)", telemetryView);
+    cmd.AddValue("telemetryTop", "Components listed per telemetry block by the viewer", telemetryTop);
+    cmd.AddValue("convertFadingTrace", "Convert --fadingTrace to this binary trace and exit", convertFadingTrace);
+    cmd.AddValue("convertMobilityTrace", "Convert the text --mobilityTrace (\"ue time x y\" lines) to this binary trace and exit", convertMobilityTrace);
+    cmd.AddValue("fadingBenchmark", "Compare loading --fadingTrace and this binary trace in --sweepJobs processes", fadingBenchmark);
+    cmd.AddValue("fadingCheck", "Run the scenario with the text --fadingTrace and with this binary trace and compare", fadingCheck);
+    cmd.Parse(argc, argv);
+
+    if (!decodeEvents.empty()) {
+        return DecodeEventLog(decodeEvents);
+    }
+    if (!decodeKpi.empty()) {
+        return DecodeKpiFile(decodeKpi);
+    }
+    if (!telemetryView.empty()) {
+        return RunTelemetryViewer(telemetryView, telemetryTop);
+    }
+    if (!convertFadingTrace.empty()) {
+        return ConvertFadingTrace(config.fadingTrace, convertFadingTrace, 100, config.fadingSamples);
+    }
+    if (!convertMobilityTrace.empty()) {
+        return ConvertMobilityTrace(config.mobilityTrace, convertMobilityTrace);
+    }
+    if (!fadingBenchmark.empty()) {
+        return RunFadingLoadBenchmark(config, fadingBenchmark, sweepJobs);
+    }
+    if (!fadingCheck.empty()) {
+        return RunFadingTraceCheck(config, fadingCheck);
+    }
+
+    if (!scalingCompare.empty()) {
+        NS_ABORT_MSG_IF(scalingBaseline.empty(), "--scalingCompare needs --scalingBaseline");
+        return CompareScalingTables(scalingCompare, scalingBaseline, regressionThreshold) > 0 ? 1 : 0;
+    }
+    if (scalingBenchmark) {
+        return RunScalingBenchmark(config, scalingOut, scalingBaseline, regressionThreshold, scalingJobs,
+                                   scalingRepeats);
+    }
+    if (validateScreening > 0) {
+        std::vector<SweepPoint> points;
+        if (!sweep.empty() || !sweepList.empty()) {
+            points = sweep.empty() ? ParseSweepList(sweepList) : ParseSweepGrid(sweep);
+        }
+        return RunScreeningValidation(config, points, validateScreening, validationOut, sweepJobs);
+    }
+    if (replication.maxRuns > 0) {
+        return RunReplications(config, replication, replicationOut, sweepJobs);
+    }
+    if (trafficBenchmark > 0) {
+        return RunTrafficBenchmark(config, trafficBenchmark, benchmarkOut, sweepJobs, equivalenceMargin);
+    }
+    if (attachBenchmark > 0) {
+        return RunAttachBenchmark(config, attachBenchmark, attachBenchmarkOut, sweepJobs);
+    }
+    if (validateBranches) {
+        return RunBranchValidation(config, branchOut, sweepJobs);
+    }
+    if (!branchSpec.empty()) {
+        return RunBranches(config, ParseBranches(branchSpec), branchOut, sweepJobs);
+    }
+    if (!sweep.empty() || !sweepList.empty()) {
+        std::vector<SweepPoint> points = sweep.empty() ? ParseSweepList(sweepList) : ParseSweepGrid(sweep);
+        return RunSweep(config, points, sweepOut, sweepJobs);
+    }
+
+    SimulationResult result = RunSimulation(config);
+    PrintResult(result);
+    return 0;
+}